@@ -0,0 +1,70 @@
+/*
+ * fault_stubs.h — faulting code shared by the recovery benchmarks
+ *
+ * The NULL calls and NOTREACHED stubs steam_cef_gpu_fix.so recovers in
+ * Chromium, in the forms its handlers unwind without CFI: every faulting
+ * frame keeps its frame pointer. Build users with -fno-omit-frame-pointer
+ * -fno-optimize-sibling-calls.
+ *
+ * License: MIT
+ */
+
+#ifndef FAULT_STUBS_H
+#define FAULT_STUBS_H
+
+static int (*volatile null_fn)(void) = NULL;
+
+/* Case 1: call through NULL, recovered by returning 0 to the caller */
+__attribute__((noinline)) static int segv_null_call(void) {
+    return null_fn();
+}
+
+/*
+ * Case 2: read through NULL, recovered by returning 0 from this frame.
+ * Written out by hand: the compiler drops the frame of a leaf function
+ * even with -fno-omit-frame-pointer, and this one must have its own.
+ */
+int bench_null_deref(void);
+__asm__(
+    ".text\n"
+    ".type bench_null_deref, @function\n"
+    "bench_null_deref:\n"
+    "    push %rbp\n"
+    "    mov  %rsp, %rbp\n"
+    "    xor  %eax, %eax\n"
+    "    mov  (%rax), %eax\n"
+    "    pop  %rbp\n"
+    "    ret\n"
+    ".size bench_null_deref, .-bench_null_deref\n"
+);
+
+/* NOTREACHED/IMMEDIATE_CRASH stubs, as emitted for Chromium's CHECKs */
+int bench_notreached_int3(void);
+int bench_notreached_ud2(void);
+__asm__(
+    ".text\n"
+    ".type bench_notreached_int3, @function\n"
+    "bench_notreached_int3:\n"
+    "    push %rbp\n"
+    "    mov  %rsp, %rbp\n"
+    "    int3\n"
+    "    ud2\n"
+    "    int3\n"
+    ".size bench_notreached_int3, .-bench_notreached_int3\n"
+    ".type bench_notreached_ud2, @function\n"
+    "bench_notreached_ud2:\n"
+    "    push %rbp\n"
+    "    mov  %rsp, %rbp\n"
+    "    ud2\n"
+    "    int3\n"
+    ".size bench_notreached_ud2, .-bench_notreached_ud2\n"
+);
+
+/* The stub's caller; crash_handler() returns past it, to our loop */
+__attribute__((noinline)) static int trap_caller(int (*stub)(void)) {
+    int r = stub();
+    __asm__ volatile ("" ::: "memory");
+    return r + 1;
+}
+
+#endif
@@ -0,0 +1,63 @@
+/*
+ * mock_libva.c — stand-in for libva.so.2 without a backend driver
+ *
+ * Built as bench/libva.so.2 for the mock steamwebhelper. vaInitialize()
+ * calls through the NULL vtable slot at offset 0x78, which is what the
+ * real libva does on the affected systems — unless LIBVA_DRIVER_NAME and
+ * LIBVA_DRIVERS_PATH name a driver it can load and initialise, such as
+ * steamfix_null_drv_video.so. vaGetDisplayDRM() lives here too; the real
+ * one is in libva-drm.so.2.
+ *
+ * License: MIT
+ */
+
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+struct mock_vtable { int (*slot[32])(void *ctx); };
+struct mock_ctx    { struct mock_vtable *vtable; int fd; };
+
+void *vaGetDisplayDRM(int fd) {
+    struct mock_ctx *ctx = calloc(1, sizeof(*ctx));
+    if (!ctx)
+        return NULL;
+    ctx->vtable = calloc(1, sizeof(*ctx->vtable));
+    ctx->fd = fd;
+    return ctx;
+}
+
+/* The driver's __vaDriverInit_1_0(), given a zeroed VADriverContext */
+static int load_driver(void) {
+    const char *name = getenv("LIBVA_DRIVER_NAME");
+    const char *dir = getenv("LIBVA_DRIVERS_PATH");
+    char path[512];
+    if (!name || !dir ||
+        snprintf(path, sizeof(path), "%s/%s_drv_video.so", dir, name) >= (int)sizeof(path))
+        return -1;
+    void *driver = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    int (*init)(void *) = driver ? (int (*)(void *))dlsym(driver, "__vaDriverInit_1_0") : NULL;
+    if (!init)
+        return -1;
+    static void *vtable[128];
+    static struct { void *data; void **vtable; char rest[256]; } context;
+    context.vtable = vtable;
+    return init(&context);
+}
+
+int vaInitialize(void *dpy, int *major, int *minor) {
+    struct mock_ctx *ctx = dpy;
+    *major = 1;
+    *minor = 20;
+    if (load_driver() == 0)
+        return 0;
+    /* No driver was loaded, so nothing ever filled the vtable in */
+    return ctx->vtable->slot[0x78 / sizeof(void *)](ctx);
+}
+
+int vaTerminate(void *dpy) {
+    struct mock_ctx *ctx = dpy;
+    free(ctx->vtable);
+    free(ctx);
+    return 0;
+}
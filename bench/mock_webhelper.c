@@ -0,0 +1,141 @@
+/*
+ * mock_webhelper.c — the parts of steamwebhelper's startup that crash
+ *
+ * The browser process re-executes itself as a GPU process, the way CEF
+ * does, and respawns it when it dies; after six crashes it gives up like
+ * Chrome ("GPU process isn't usable. Goodbye."). The GPU process
+ *
+ *   1. installs a crashpad-style SIGSEGV/SIGTRAP/SIGILL/SIGSYS handler that
+ *      kills the process after ~20 ms spent "writing a minidump";
+ *   2. probes clone3(), which Chrome 126's seccomp policy punishes: if
+ *      it doesn't fail with ENOSYS the process dies of SIGSYS;
+ *   3. dlopen()s libva.so.2 (bench/libva.so.2, from mock_libva.c) and
+ *      calls vaGetDisplayDRM() + vaInitialize() through dlsym(), as
+ *      Chromium's generated stubs do.
+ *
+ * Once a GPU process survives all three, the browser "maps its first
+ * window": it writes a byte to the fd in STEAMFIX_BENCH_READY_FD, which
+ * is what steamfix-coldstart times, and then idles until killed.
+ *
+ * License: MIT
+ */
+
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
+#define MAX_GPU_CRASHES 6
+#define MINIDUMP_NS     20000000    /* what a minidump roughly costs */
+
+static void crashpad_handler(int sig) {
+    /* The crashing thread waits for the handler process to write a dump */
+    static const char msg[] = "mock_webhelper: crashpad caught a signal\n";
+    struct timespec dump = { 0, MINIDUMP_NS };
+    (void)!write(STDERR_FILENO, msg, sizeof(msg) - 1);
+    nanosleep(&dump, NULL);
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+static void install_crashpad(void) {
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = crashpad_handler;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGSEGV, &sa, NULL);
+    sigaction(SIGTRAP, &sa, NULL);
+    sigaction(SIGILL,  &sa, NULL);
+    sigaction(SIGSYS,  &sa, NULL);      /* seccomp violations */
+}
+
+static void sandbox_clone3(void) {
+    uint64_t args[11] = { 0 };
+    /* size 0 is invalid: EINVAL if clone3 exists, nothing is created */
+    long ret = syscall(SYS_clone3, args, (size_t)0);
+    if (ret == -1 && errno == ENOSYS)
+        return;
+    raise(SIGSYS);
+}
+
+static void init_libva(void) {
+    char path[PATH_MAX];
+    ssize_t n = readlink("/proc/self/exe", path, sizeof(path) - 16);
+    if (n <= 0)
+        return;
+    path[n] = 0;
+    char *slash = strrchr(path, '/');
+    strcpy(slash ? slash + 1 : path, "libva.so.2");
+
+    void *va = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    if (!va)
+        return;
+    void *(*get_display)(int) = (void *(*)(int))dlsym(va, "vaGetDisplayDRM");
+    int (*initialize)(void *, int *, int *) =
+        (int (*)(void *, int *, int *))dlsym(va, "vaInitialize");
+    if (!get_display || !initialize)
+        return;
+
+    int fd = open("/dev/dri/renderD128", O_RDWR | O_CLOEXEC);
+    void *dpy = get_display(fd);
+    int major, minor;
+    if (dpy && initialize(dpy, &major, &minor) != 0)
+        fputs("mock_webhelper: VA-API unavailable, decoding in software\n", stderr);
+    if (fd >= 0)
+        close(fd);
+}
+
+static int gpu_main(void) {
+    install_crashpad();
+    sandbox_clone3();
+    init_libva();
+    /* Initialised: tell the browser, then serve until it goes away */
+    (void)!write(STDOUT_FILENO, "u", 1);
+    pause();
+    return 0;
+}
+
+static int browser_main(void) {
+    for (int crashes = 0; crashes < MAX_GPU_CRASHES; crashes++) {
+        int fds[2];
+        if (pipe2(fds, O_CLOEXEC) != 0)
+            return 1;
+        pid_t pid = fork();
+        if (pid == 0) {
+            dup2(fds[1], STDOUT_FILENO);
+            execl("/proc/self/exe", "mock_webhelper", "--type=gpu-process", (char *)NULL);
+            _exit(127);
+        }
+        close(fds[1]);
+
+        char c;
+        ssize_t n = read(fds[0], &c, 1);
+        close(fds[0]);
+        if (n == 1) {
+            const char *ready = getenv("STEAMFIX_BENCH_READY_FD");
+            if (ready)
+                (void)!write(atoi(ready), "w", 1);
+            for (;;)
+                pause();
+        }
+        waitpid(pid, NULL, 0);
+    }
+    fputs("mock_webhelper: GPU process isn't usable. Goodbye.\n", stderr);
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1 && strcmp(argv[1], "--type=gpu-process") == 0)
+        return gpu_main();
+    return browser_main();
+}
@@ -0,0 +1,197 @@
+/*
+ * steamfix_bench.c — microbenchmarks for steam_cef_gpu_fix.so
+ *
+ * `make bench` runs this plain and with the library in LD_PRELOAD, and
+ * collects the output in bench_output.txt. Every result is one line:
+ *
+ *   <config> <metric> <value> <unit>
+ *
+ * where <config> is "libc" or "preload", or $STEAMFIX_BENCH_CONFIG, which
+ * `make bench` sets for its other preloaded runs ("minimal" for
+ * steam_cef_gpu_fix_min.so, "hotpatch"). Recovery metrics only exist
+ * under "preload" (without the library those faults are fatal). The
+ * interposer metrics exist in both, so the overhead of an override is
+ * `preload <metric>` minus `libc <metric>`; each run also times the same
+ * call through libc's own entry point (`*_libc`) as a baseline.
+ *
+ * Timings are the minimum over ROUNDS rounds of ITERS iterations.
+ *
+ * License: MIT
+ */
+
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/filter.h>
+#include <linux/seccomp.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <sys/utsname.h>
+#include <sys/wait.h>
+
+#include "fault_stubs.h"
+
+#define ROUNDS      7
+#define ITERS       20000
+#define EXEC_ITERS  200
+
+static const char *config;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void report(const char *metric, double value, const char *unit) {
+    printf("%s %s %.1f %s\n", config, metric, value, unit);
+    fflush(stdout);
+}
+
+#define MEASURE(metric, iters, body) do {                       \
+        double best = 1e300;                                    \
+        for (int r_ = 0; r_ < ROUNDS; r_++) {                   \
+            double t_ = now_ns();                               \
+            for (long i_ = 0; i_ < (iters); i_++) { body; }     \
+            t_ = (now_ns() - t_) / (double)(iters);             \
+            if (t_ < best)                                      \
+                best = t_;                                      \
+        }                                                       \
+        report(metric, best, "ns");                             \
+    } while (0)
+
+/* ── fault recovery ─────────────────────────────────────────────────── */
+static void bench_recovery(void) {
+    MEASURE("segv_case1", ITERS, segv_null_call());
+    MEASURE("segv_case2", ITERS, bench_null_deref());
+    MEASURE("trap_int3", ITERS, trap_caller(bench_notreached_int3));
+    MEASURE("trap_ud2", ITERS, trap_caller(bench_notreached_ud2));
+}
+
+/* ── interposer overhead ────────────────────────────────────────────── */
+typedef long (*syscall_t)(long, ...);
+typedef int (*sigaction_t)(int, const struct sigaction *, struct sigaction *);
+typedef void (*(*signal_t)(int, void (*)(int)))(int);
+
+static void on_usr1(int sig) { (void)sig; }
+
+static void bench_overrides(void) {
+    void *libc = dlopen("libc.so.6", RTLD_NOW | RTLD_NOLOAD);
+    syscall_t   libc_syscall   = (syscall_t)dlsym(libc, "syscall");
+    sigaction_t libc_sigaction = (sigaction_t)dlsym(libc, "sigaction");
+    signal_t    libc_signal    = (signal_t)dlsym(libc, "signal");
+    struct sigaction old;
+
+    /* An unimplemented number keeps the kernel side as short as it gets */
+    MEASURE("syscall", ITERS, syscall(1000, 0, 0, 0, 0, 0, 0));
+    MEASURE("syscall_libc", ITERS, libc_syscall(1000, 0, 0, 0, 0, 0, 0));
+    MEASURE("syscall_gettid", ITERS, syscall(SYS_gettid));
+    MEASURE("syscall_gettid_libc", ITERS, libc_syscall(SYS_gettid));
+    MEASURE("sigaction", ITERS, sigaction(SIGUSR1, NULL, &old));
+    MEASURE("sigaction_libc", ITERS, libc_sigaction(SIGUSR1, NULL, &old));
+    MEASURE("signal", ITERS, signal(SIGUSR1, on_usr1));
+    MEASURE("signal_libc", ITERS, libc_signal(SIGUSR1, on_usr1));
+}
+
+/* ── thread creation ────────────────────────────────────────────────── */
+#define THREAD_ITERS 2000
+
+static void *thread_noop(void *arg) { return arg; }
+
+static void thread_create_join(void) {
+    pthread_t t;
+    if (pthread_create(&t, NULL, thread_noop, NULL) == 0)
+        pthread_join(t, NULL);
+}
+
+/* clone3 straight to the kernel: not through syscall(), which we override */
+static long raw_clone3_null(void) {
+    long ret;
+    __asm__ volatile ("syscall" : "=a"(ret) : "a"((long)SYS_clone3), "D"(0L), "S"(0L)
+                      : "rcx", "r11", "memory");
+    return ret;
+}
+
+/*
+ * pthread_create() + join, then the same in a child that denies clone3
+ * with ENOSYS the way Chrome's sandbox does: there glibc pays for a
+ * refused clone3 (`clone3_refused`) before every clone().
+ */
+static void bench_threads(void) {
+    MEASURE("thread_create", THREAD_ITERS, thread_create_join());
+
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        struct sock_filter filter[] = {
+            BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(struct seccomp_data, nr)),
+            BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, SYS_clone3, 0, 1),
+            BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ERRNO | (ENOSYS & SECCOMP_RET_DATA)),
+            BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ALLOW),
+        };
+        struct sock_fprog prog = { sizeof(filter) / sizeof(filter[0]), filter };
+        if (prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0) == 0 &&
+            prctl(PR_SET_SECCOMP, SECCOMP_MODE_FILTER, &prog) == 0) {
+            MEASURE("clone3_refused", ITERS, raw_clone3_null());
+            MEASURE("thread_create_sandboxed", THREAD_ITERS, thread_create_join());
+        }
+        _exit(0);
+    }
+    int status;
+    waitpid(pid, &status, 0);
+}
+
+/* ── process start ──────────────────────────────────────────────────── */
+/* fork + exec + exit of ourselves; LD_PRELOAD (if any) is inherited */
+static void bench_exec(void) {
+    double best = 1e300;
+    for (int r = 0; r < ROUNDS; r++) {
+        double t = now_ns();
+        for (int i = 0; i < EXEC_ITERS; i++) {
+            pid_t pid = fork();
+            if (pid == 0) {
+                execl("/proc/self/exe", "steamfix-bench", "--noop", (char *)NULL);
+                _exit(127);
+            }
+            int status;
+            waitpid(pid, &status, 0);
+        }
+        t = (now_ns() - t) / EXEC_ITERS;
+        if (t < best)
+            best = t;
+    }
+    report("process_start", best / 1000.0, "us");
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1 && strcmp(argv[1], "--noop") == 0)
+        return 0;
+
+    /* LD_PRELOAD interposition shows up as a syscall() that isn't libc's */
+    void *libc = dlopen("libc.so.6", RTLD_NOW | RTLD_NOLOAD);
+    int preloaded = dlsym(RTLD_DEFAULT, "syscall") != dlsym(libc, "syscall");
+    config = preloaded ? "preload" : "libc";
+    if (preloaded && getenv("STEAMFIX_BENCH_CONFIG"))
+        config = getenv("STEAMFIX_BENCH_CONFIG");
+
+    struct utsname u;
+    uname(&u);
+    printf("# steamfix-bench %s kernel=%s rounds=%d iters=%d\n",
+           config, u.release, ROUNDS, ITERS);
+
+    if (preloaded)
+        bench_recovery();
+    bench_overrides();
+    bench_threads();
+    bench_exec();
+    return 0;
+}
@@ -0,0 +1,382 @@
+/*
+ * steamfix_coldstart.c — end-to-end startup benchmark
+ *
+ *   steamfix-coldstart [-n runs] [-t seconds] [-l lib.so [-p]] [-c comm]
+ *                      [-w probe-cmd] -- command [args...]
+ *
+ * Launches `command` repeatedly, plain and (with -l) with the library in
+ * LD_PRELOAD (-p: only with it), and measures per run
+ *
+ *   coldstart     wall-clock time from exec to the first mapped window
+ *   gpu_respawns  GPU processes (--type=gpu-process) started, minus one
+ *   peak_rss      peak summed RSS of the process tree (with -c, only of
+ *                 processes whose comm is <comm>, e.g. steamwebhelper)
+ *
+ * "First window" is whichever comes first of a byte written to the fd in
+ * STEAMFIX_BENCH_READY_FD (bench/mock-webhelper does this) or the probe
+ * command exiting 0; for real Steam that's something like
+ *
+ *   -w 'xdotool search --onlyvisible --class steam' -c steamwebhelper -- steam
+ *
+ * or the equivalent query of your Wayland compositor. A run that exits or
+ * times out without a window is reported as such. The tree is found by
+ * walking ppid links from the harness, which is a child subreaper, so
+ * daemonised zygotes stay in it. Results use steamfix-bench's format,
+ * median over runs, and like it $STEAMFIX_BENCH_CONFIG renames "preload":
+ *
+ *   <config> <metric> <value> <unit>
+ *
+ * License: MIT
+ */
+
+#define _GNU_SOURCE
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/prctl.h>
+#include <sys/utsname.h>
+#include <sys/wait.h>
+
+#define MAX_RUNS    64
+#define MAX_PROCS   1024
+#define TICK_MS     2
+#define PROBE_MS    100
+
+struct proc {
+    int pid, ppid;
+    int gpu;                    /* seen with --type=gpu-process          */
+    int in_tree;
+    long rss_pages;
+    char comm[32];
+};
+
+struct run {
+    double ms;                  /* to first window, or to exit/timeout   */
+    int window;
+    int gpu;
+    long peak_rss_kb;
+};
+
+static int    runs = 5;
+static double timeout_s = 60;
+static const char *lib;
+static int preload_only;
+static const char *comm_filter;
+static const char *probe;
+static char **command;
+
+/* Processes seen during the current run; `gpu` sticks across scans */
+static struct proc seen[MAX_PROCS];
+static int nseen;
+static int gpu_started;
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec / 1e6;
+}
+
+static struct proc *lookup(int pid) {
+    for (int i = 0; i < nseen; i++)
+        if (seen[i].pid == pid)
+            return &seen[i];
+    if (nseen == MAX_PROCS)
+        return NULL;
+    memset(&seen[nseen], 0, sizeof(seen[nseen]));
+    seen[nseen].pid = pid;
+    return &seen[nseen++];
+}
+
+static int read_file(const char *path, char *buf, size_t len) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return -1;
+    ssize_t n = read(fd, buf, len - 1);
+    close(fd);
+    if (n < 0)
+        return -1;
+    buf[n] = 0;
+    return (int)n;
+}
+
+static int is_gpu_process(int pid) {
+    char path[64], buf[4096];
+    snprintf(path, sizeof(path), "/proc/%d/cmdline", pid);
+    int n = read_file(path, buf, sizeof(buf));
+    for (int i = 0; i < n; i += (int)strlen(buf + i) + 1)
+        if (strcmp(buf + i, "--type=gpu-process") == 0)
+            return 1;
+    return 0;
+}
+
+/* Refresh `seen` from /proc; returns the tree's RSS in KiB */
+static long scan_tree(int self) {
+    for (int i = 0; i < nseen; i++)
+        seen[i].in_tree = 0, seen[i].ppid = 0;
+
+    DIR *d = opendir("/proc");
+    if (!d)
+        return 0;
+    struct dirent *de;
+    while ((de = readdir(d))) {
+        int pid = atoi(de->d_name);
+        if (pid <= 0 || pid == self)
+            continue;
+        char path[64], buf[512];
+        snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+        if (read_file(path, buf, sizeof(buf)) <= 0)
+            continue;
+        /* pid (comm) state ppid ... — comm may contain spaces or ')' */
+        char *open_paren = strchr(buf, '('), *close_paren = strrchr(buf, ')');
+        int ppid;
+        if (!open_paren || !close_paren || sscanf(close_paren + 2, "%*c %d", &ppid) != 1)
+            continue;
+        if (ppid == 0)
+            continue;
+        struct proc *p = lookup(pid);
+        if (!p)
+            continue;
+        p->ppid = ppid;
+        size_t len = (size_t)(close_paren - open_paren - 1);
+        if (len >= sizeof(p->comm))
+            len = sizeof(p->comm) - 1;
+        memcpy(p->comm, open_paren + 1, len);
+        p->comm[len] = 0;
+
+        snprintf(path, sizeof(path), "/proc/%d/statm", pid);
+        long size;
+        p->rss_pages = 0;
+        if (read_file(path, buf, sizeof(buf)) > 0)
+            sscanf(buf, "%ld %ld", &size, &p->rss_pages);
+    }
+    closedir(d);
+
+    /* Mark descendants of the harness; repeat until nothing changes */
+    for (int changed = 1; changed; ) {
+        changed = 0;
+        for (int i = 0; i < nseen; i++) {
+            struct proc *p = &seen[i];
+            if (p->in_tree || !p->ppid)
+                continue;
+            if (p->ppid == self) {
+                p->in_tree = changed = 1;
+                continue;
+            }
+            for (int j = 0; j < nseen; j++)
+                if (seen[j].pid == p->ppid && seen[j].in_tree) {
+                    p->in_tree = changed = 1;
+                    break;
+                }
+        }
+    }
+
+    long rss = 0, page_kb = sysconf(_SC_PAGESIZE) / 1024;
+    for (int i = 0; i < nseen; i++) {
+        struct proc *p = &seen[i];
+        if (!p->in_tree)
+            continue;
+        /* The cmdline is the parent's until exec, so keep checking */
+        if (!p->gpu && is_gpu_process(p->pid)) {
+            p->gpu = 1;
+            gpu_started++;
+        }
+        if (!comm_filter || strcmp(p->comm, comm_filter) == 0)
+            rss += p->rss_pages * page_kb;
+    }
+    return rss;
+}
+
+static int run_probe(void) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        int null = open("/dev/null", O_WRONLY);
+        dup2(null, STDOUT_FILENO);
+        dup2(null, STDERR_FILENO);
+        execl("/bin/sh", "sh", "-c", probe, (char *)NULL);
+        _exit(127);
+    }
+    int status;
+    if (pid < 0 || waitpid(pid, &status, 0) != pid)
+        return 0;
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+/* Reaps whatever has exited and counts what's left */
+static int tree_size(int self) {
+    while (waitpid(-1, NULL, WNOHANG) > 0)
+        ;
+    scan_tree(self);
+    int n = 0;
+    for (int i = 0; i < nseen; i++)
+        n += seen[i].in_tree;
+    return n;
+}
+
+/* Kill everything that's still in the tree and reap it */
+static void teardown(int self) {
+    for (int sig = SIGTERM; tree_size(self); sig = SIGKILL) {
+        for (int i = 0; i < nseen; i++)
+            if (seen[i].in_tree)
+                kill(seen[i].pid, sig);
+        double deadline = now_ms() + 2000;
+        while (now_ms() < deadline && tree_size(self))
+            usleep(TICK_MS * 1000);
+    }
+}
+
+static struct run run_once(int preload) {
+    struct run r = { 0 };
+    int self = getpid(), ready[2];
+    nseen = gpu_started = 0;
+    if (pipe2(ready, O_CLOEXEC) != 0) {
+        perror("pipe2");
+        exit(1);
+    }
+
+    double t0 = now_ms();
+    pid_t child = fork();
+    if (child == 0) {
+        char fd[16];
+        int wfd = dup(ready[1]);        /* without O_CLOEXEC */
+        snprintf(fd, sizeof(fd), "%d", wfd);
+        setenv("STEAMFIX_BENCH_READY_FD", fd, 1);
+        if (preload)
+            setenv("LD_PRELOAD", lib, 1);
+        else
+            unsetenv("LD_PRELOAD");
+        execvp(command[0], command);
+        perror(command[0]);
+        _exit(127);
+    }
+    close(ready[1]);
+
+    double next_probe = t0 + PROBE_MS;
+    for (;;) {
+        struct pollfd pfd = { .fd = ready[0], .events = POLLIN };
+        char c;
+        if (poll(&pfd, 1, TICK_MS) > 0 && read(ready[0], &c, 1) == 1) {
+            r.window = 1;
+            break;
+        }
+        double t = now_ms();
+        long rss = scan_tree(self);
+        if (rss > r.peak_rss_kb)
+            r.peak_rss_kb = rss;
+
+        int status;
+        pid_t w;
+        while ((w = waitpid(-1, &status, WNOHANG)) > 0)
+            if (w == child)
+                child = 0;
+        if (!child)
+            break;
+        if (probe && t >= next_probe) {
+            if (run_probe()) {
+                r.window = 1;
+                break;
+            }
+            next_probe = now_ms() + PROBE_MS;
+        }
+        if (t - t0 > timeout_s * 1e3)
+            break;
+    }
+    r.ms = now_ms() - t0;
+    /* A last look, for what came up together with the window */
+    long rss = scan_tree(self);
+    if (rss > r.peak_rss_kb)
+        r.peak_rss_kb = rss;
+    r.gpu = gpu_started;
+    close(ready[0]);
+    teardown(self);
+    return r;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double median(double *v, int n) {
+    qsort(v, (size_t)n, sizeof(*v), cmp_double);
+    return n % 2 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2;
+}
+
+static void bench_config(const char *config, int preload) {
+    double ms[MAX_RUNS], exit_ms[MAX_RUNS], respawns[MAX_RUNS], rss[MAX_RUNS];
+    int windows = 0, exits = 0;
+
+    for (int i = 0; i < runs; i++) {
+        struct run r = run_once(preload);
+        printf("# %s run %d: %s after %.1f ms, %d GPU processes, peak RSS %ld KiB\n",
+               config, i + 1, r.window ? "window" : "no window", r.ms, r.gpu,
+               r.peak_rss_kb);
+        if (r.window)
+            ms[windows++] = r.ms;
+        else
+            exit_ms[exits++] = r.ms;
+        respawns[i] = r.gpu > 0 ? r.gpu - 1 : 0;
+        rss[i] = (double)r.peak_rss_kb;
+    }
+
+    if (windows)
+        printf("%s coldstart %.1f ms\n", config, median(ms, windows));
+    else
+        printf("%s coldstart - ms\n", config);
+    if (exits)
+        printf("%s no_window %.1f ms\n", config, median(exit_ms, exits));
+    printf("%s first_window %d/%d runs\n", config, windows, runs);
+    printf("%s gpu_respawns %.0f count\n", config, median(respawns, runs));
+    printf("%s peak_rss %.0f KiB\n", config, median(rss, runs));
+    fflush(stdout);
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "usage: %s [-n runs] [-t seconds] [-l lib.so [-p]] [-c comm] [-w probe-cmd]"
+            " -- command [args...]\n", argv0);
+    exit(2);
+}
+
+int main(int argc, char **argv) {
+    int opt;
+    while ((opt = getopt(argc, argv, "n:t:l:pc:w:h")) != -1) {
+        switch (opt) {
+        case 'n': runs = atoi(optarg); break;
+        case 't': timeout_s = atof(optarg); break;
+        case 'l': lib = optarg; break;
+        case 'p': preload_only = 1; break;
+        case 'c': comm_filter = optarg; break;
+        case 'w': probe = optarg; break;
+        default:  usage(argv[0]);
+        }
+    }
+    if (optind >= argc || runs < 1 || runs > MAX_RUNS || timeout_s <= 0 ||
+        (preload_only && !lib))
+        usage(argv[0]);
+    command = argv + optind;
+
+    if (lib && strchr(lib, '/') == NULL) {
+        fprintf(stderr, "%s: -l needs a path, not a bare soname\n", argv[0]);
+        return 2;
+    }
+    /* Orphaned grandchildren (zygotes) are reparented to us, not init */
+    prctl(PR_SET_CHILD_SUBREAPER, 1);
+
+    struct utsname u;
+    uname(&u);
+    printf("# steamfix-coldstart kernel=%s runs=%d command=%s\n",
+           u.release, runs, command[0]);
+    if (!preload_only)
+        bench_config("libc", 0);
+    if (lib) {
+        const char *config = getenv("STEAMFIX_BENCH_CONFIG");
+        bench_config(config && *config ? config : "preload", 1);
+    }
+    return 0;
+}
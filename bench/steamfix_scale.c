@@ -0,0 +1,124 @@
+/*
+ * steamfix_scale.c — fault recovery under concurrency
+ *
+ *   LD_PRELOAD=steam_cef_gpu_fix.so steamfix-scale [max-threads]
+ *
+ * Chromium's GPU process faults from several threads at once, and the
+ * same site tends to fault on all of them. This starts 1, 2, 4, ... up to
+ * max-threads (default 64) threads that all fault at the same sites as
+ * fast as they recover, once with NULL calls and once with int3 stubs,
+ * and reports recoveries per second per core in steamfix-bench's format:
+ *
+ *   preload scale_segv_<n> <value> rec/s/core
+ *   preload scale_int3_<n> <value> rec/s/core
+ *
+ * "Per core" divides by min(n, online CPUs), so flat numbers mean the
+ * recovery path scales and falling ones mean threads contend on shared
+ * state. Each point is the best of ROUNDS runs of RUN_NS. Without the
+ * library the first fault is fatal, so it refuses to run.
+ *
+ * License: MIT
+ */
+
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/utsname.h>
+
+#include "fault_stubs.h"
+
+#define ROUNDS       3
+#define RUN_NS       100000000ull       /* 100 ms per run */
+#define MAX_THREADS  64
+
+static const char *config;
+static int (*stub)(void);               /* what the threads fault in */
+static pthread_barrier_t start;
+static volatile int stop;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void *fault_loop(void *arg) {
+    unsigned long *count = arg;
+    pthread_barrier_wait(&start);
+    while (!stop) {
+        for (int i = 0; i < 64; i++)
+            trap_caller(stub);
+        *count += 64;
+    }
+    return NULL;
+}
+
+/* Recoveries per second per core with `n` threads faulting in `fn` */
+static double run(int (*fn)(void), int n, int cpus) {
+    pthread_t tid[MAX_THREADS];
+    unsigned long count[MAX_THREADS][8];    /* a cache line each */
+
+    stub = fn;
+    stop = 0;
+    memset(count, 0, sizeof(count));
+    pthread_barrier_init(&start, NULL, (unsigned)n + 1);
+    for (int i = 0; i < n; i++)
+        pthread_create(&tid[i], NULL, fault_loop, count[i]);
+    pthread_barrier_wait(&start);
+
+    double t = now_ns();
+    struct timespec run = { 0, (long)RUN_NS };
+    nanosleep(&run, NULL);
+    stop = 1;
+    unsigned long total = 0;
+    for (int i = 0; i < n; i++) {
+        pthread_join(tid[i], NULL);
+        total += count[i][0];
+    }
+    t = now_ns() - t;
+    pthread_barrier_destroy(&start);
+    return (double)total / (t / 1e9) / (n < cpus ? n : cpus);
+}
+
+static void scale(const char *name, int (*fn)(void), int max, int cpus) {
+    for (int n = 1; n <= max; n *= 2) {
+        double best = 0;
+        for (int r = 0; r < ROUNDS; r++) {
+            double v = run(fn, n, cpus);
+            if (v > best)
+                best = v;
+        }
+        printf("%s scale_%s_%d %.1f rec/s/core\n", config, name, n, best);
+        fflush(stdout);
+    }
+}
+
+int main(int argc, char **argv) {
+    int max = argc > 1 ? atoi(argv[1]) : MAX_THREADS;
+    if (max < 1 || max > MAX_THREADS)
+        max = MAX_THREADS;
+
+    void *libc = dlopen("libc.so.6", RTLD_NOW | RTLD_NOLOAD);
+    if (dlsym(RTLD_DEFAULT, "syscall") == dlsym(libc, "syscall")) {
+        fputs("steamfix-scale: run with steam_cef_gpu_fix.so in LD_PRELOAD\n", stderr);
+        return 1;
+    }
+    config = getenv("STEAMFIX_BENCH_CONFIG") ? getenv("STEAMFIX_BENCH_CONFIG") : "preload";
+
+    int cpus = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus < 1)
+        cpus = 1;
+    struct utsname u;
+    uname(&u);
+    printf("# steamfix-scale %s kernel=%s cpus=%d rounds=%d run=%llums\n",
+           config, u.release, cpus, ROUNDS, RUN_NS / 1000000);
+
+    scale("segv", segv_null_call, max, cpus);
+    scale("int3", bench_notreached_int3, max, cpus);
+    return 0;
+}
@@ -0,0 +1,47 @@
+/*
+ * gen_crash_sites.c — compile crash_sites.txt into crash_sites.h
+ *
+ *   gen-crash-sites < crash_sites.txt > crash_sites.h
+ *
+ * Parses the site list (format documented at the top of crash_sites.txt)
+ * and emits it as the perfect-hash table steamfix_sitegen.h builds: a
+ * static table the library indexes with steamfix_site_slot().
+ *
+ * License: MIT
+ */
+
+#include "steamfix_sitegen.h"
+
+int main(void) {
+    char line[512];
+    sitegen_tool = "gen-crash-sites";
+    while (fgets(line, sizeof(line), stdin)) {
+        sitegen_line++;
+        line[strcspn(line, "#\n")] = 0;
+        char module[128], offset[64], kinds[128], extra;
+        int n = sscanf(line, "%127s %63s %127s %c", module, offset, kinds, &extra);
+        if (n <= 0)
+            continue;
+        if (n != 3)
+            sitegen_die("expected <module> <offset> <kinds>");
+        sitegen_add(module, offset, kinds);
+    }
+
+    uint64_t seed;
+    unsigned bits = sitegen_solve(&seed);
+
+    printf("/* Generated by gen-crash-sites from crash_sites.txt — do not edit */\n");
+    printf("#define STEAMFIX_SITES_BITS   %u\n", bits);
+    printf("#define STEAMFIX_SITES_SEED   0x%016llxull\n", (unsigned long long)seed);
+    printf("#define STEAMFIX_SITES_COUNT  %u\n\n", sitegen_count);
+    printf("static const struct steamfix_site steamfix_sites[1u << STEAMFIX_SITES_BITS] = {\n");
+    for (unsigned i = 0; i < sitegen_count; i++) {
+        const struct steamfix_site *s = &sitegen_entries[i].site;
+        printf("    [%u] = { 0x%016llxull, 0x%016llxull, 0x%x },  /* %s */\n",
+               steamfix_site_slot(s->module, s->offset, seed, bits),
+               (unsigned long long)s->module, (unsigned long long)s->offset,
+               s->kinds, sitegen_entries[i].text);
+    }
+    printf("};\n");
+    return 0;
+}
@@ -16,18 +16,27 @@
  *   sudo apt install nvidia-vaapi-driver
  *
  * This library (fallback fix):
+ *   0. Export vaInitialize()/vaGetDisplayDRM() wrappers that check for a
+ *      VA-API backend driver up front and fail cleanly when there is none,
+ *      so libva never reaches the NULL vtable slot in the first place.
  *   1. Install a SIGSEGV handler that returns 0 from NULL-pointer calls
- *      instead of crashing.
+ *      instead of crashing (fallback when the pre-check is bypassed).
  *   2. Intercept sigaction() to prevent crashpad from replacing our handler.
  *   3. (Safety net) Handle SIGTRAP/SIGILL from NOTREACHED()/IMMEDIATE_CRASH()
- *      assertions by unwinding two frames to avoid infinite loops.
+ *      assertions by unwinding two frames to avoid infinite loops; with
+ *      STEAMFIX_HOTPATCH=1, rewrite stubs that keep trapping to do it inline.
  *   4. (Safety net) Intercept clone3() → ENOSYS so glibc falls back to
  *      clone(), which older seccomp sandboxes permit.
+ *   Recovery is limited to the sites in crash_sites.txt (libva, libcef).
  *
  * Usage:
- *   gcc -shared -fPIC -o steam_cef_gpu_fix.so steam_cef_gpu_fix.c -ldl
+ *   make
  *   LD_PRELOAD=$PWD/steam_cef_gpu_fix.so steam
  *
+ * Built with -DSTEAMFIX_MINIMAL (steam_cef_gpu_fix_min.so) only the
+ * handlers, sigaction()/signal() and syscall() are left, calling the
+ * kernel directly: no dlsym(), no libdl, the cheapest possible startup.
+ *
  * Tested on:
  *   - Ubuntu 24.04, kernel 6.17.0-14-generic
  *   - NVIDIA GeForce RTX 5070 Laptop GPU (Blackwell), driver 590.48.01
@@ -37,185 +46,3759 @@
  */
 
 #define _GNU_SOURCE
-#include <stdarg.h>
 #include <signal.h>
 #include <string.h>
 #include <ucontext.h>
 #include <dlfcn.h>
 #include <stdint.h>
+#include <time.h>
+#include <sched.h>
 #include <errno.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <spawn.h>
+#include <x86intrin.h>
+#include <stddef.h>
+#include <elf.h>
+#include <link.h>
+#include <linux/audit.h>
+#include <linux/filter.h>
+#include <linux/seccomp.h>
+#include <sys/auxv.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/stat.h>
 #include <sys/syscall.h>
+#include <sys/utsname.h>
 
-static int handlers_locked = 0;
+#include "steamfix_policy.h"
+#include "steamfix_telemetry.h"
+#include "steamfix_sites.h"
+#include "crash_sites.h"
 
-/* ── SIGSEGV: core fix ─────────────────────────────────────────────── */
-static void sigsegv_handler(int sig, siginfo_t *info, void *ucontext) {
-    (void)sig;
-    ucontext_t *ctx = (ucontext_t *)ucontext;
-    uint64_t rip = ctx->uc_mcontext.gregs[REG_RIP];
-    uint64_t rsp = ctx->uc_mcontext.gregs[REG_RSP];
-    uint64_t rbp = ctx->uc_mcontext.gregs[REG_RBP];
+static int handlers_locked = 0;     /* atomic: read from any thread */
 
-    /* Case 1: jumped/called to NULL (rip near 0) — return 0 to caller */
-    if (rip < 0x10000) {
-        ctx->uc_mcontext.gregs[REG_RAX] = 0;
-        ctx->uc_mcontext.gregs[REG_RIP] = *(uint64_t *)rsp;
-        ctx->uc_mcontext.gregs[REG_RSP] = rsp + 8;
+#define XSTR(x) STR(x)
+#define STR(x)  #x
+
+/* Everything is built hidden except the symbols we interpose */
+#define STEAMFIX_EXPORT __attribute__((visibility("default")))
+
+/*
+ * USDT probes, as <sys/sdt.h> (not always installed) lays them out: a nop
+ * at the probe site, plus a .note.stapsdt entry naming it and saying
+ * where its arguments are, for perf, bpftrace and SystemTap to attach to:
+ *
+ *   bpftrace -e 'usdt:/path/to/steam_cef_gpu_fix.so:steamfix:reraise {...}'
+ *
+ * Untraced, a probe is the nop. Four signed 64-bit arguments each.
+ */
+#define PROBE_ARG(n) "-8@%" #n
+#define PROBE(name, a, b, c, d)                                             \
+    __asm__ __volatile__(                                                   \
+        "990: nop\n"                                                        \
+        ".pushsection .note.stapsdt,\"?\",\"note\"\n"                       \
+        ".balign 4\n"                                                       \
+        ".4byte 992f-991f, 994f-993f, 3\n"                                  \
+        "991: .asciz \"stapsdt\"\n"                                         \
+        "992: .balign 4\n"                                                  \
+        "993: .8byte 990b, _.stapsdt.base, 0\n"                             \
+        ".asciz \"steamfix\", \"" #name "\", \""                             \
+            PROBE_ARG(0) " " PROBE_ARG(1) " " PROBE_ARG(2) " " PROBE_ARG(3) "\"\n" \
+        "994: .balign 4\n"                                                  \
+        ".popsection\n"                                                     \
+        ".ifndef _.stapsdt.base\n"                                          \
+        ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n" \
+        ".weak _.stapsdt.base\n"                                            \
+        ".hidden _.stapsdt.base\n"                                          \
+        "_.stapsdt.base: .space 1\n"                                        \
+        ".size _.stapsdt.base, 1\n"                                         \
+        ".popsection\n"                                                     \
+        ".endif\n"                                                          \
+        :: "nor"((int64_t)(a)), "nor"((int64_t)(b)),                        \
+           "nor"((int64_t)(c)), "nor"((int64_t)(d)))
+
+#ifndef STEAMFIX_MINIMAL
+/*
+ * libc's `name`, resolved with dlsym(RTLD_NEXT) and published atomically.
+ * The constructor resolves everything up front; the lazy path only runs
+ * if another library's constructor calls us before ours has run.
+ */
+static void *next_symbol(void **slot, const char *name) {
+    void *fn = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+    if (__builtin_expect(fn == NULL, 0)) {
+        fn = dlsym(RTLD_NEXT, name);
+        __atomic_store_n(slot, fn, __ATOMIC_RELEASE);
+    }
+    return fn;
+}
+#define NEXT(slot, name) ((__typeof__(slot))next_symbol((void **)&(slot), name))
+#endif
+
+/*
+ * errno as our caller sees it. That's normally ours, but under LD_AUDIT
+ * we run on a private copy of libc and callers read the base namespace's
+ * errno, so the first error there looks up that libc's __errno_location().
+ */
+#ifndef STEAMFIX_MINIMAL
+static int audit_mode = 0;          /* set by la_version() */
+static struct link_map *audit_base = NULL;  /* the application's first object */
+static int *(*caller_errno_fn)(void) = NULL;
+#endif
+
+static void set_caller_errno(int e) {
+    errno = e;
+#ifndef STEAMFIX_MINIMAL
+    if (!audit_mode)
         return;
+    int *(*fn)(void) = __atomic_load_n(&caller_errno_fn, __ATOMIC_ACQUIRE);
+    if (!fn) {
+        void *libc = dlmopen(LM_ID_BASE, "libc.so.6", RTLD_NOW | RTLD_NOLOAD);
+        fn = libc ? (int *(*)(void))dlsym(libc, "__errno_location") : NULL;
+        __atomic_store_n(&caller_errno_fn, fn, __ATOMIC_RELEASE);
     }
+    if (fn)
+        *fn() = e;
+#endif
+}
 
-    /* Case 2: read/write to NULL — return 0 from current function */
-    if ((uintptr_t)info->si_addr < 0x10000) {
-        ctx->uc_mcontext.gregs[REG_RAX] = 0;
-        if (rbp > 0x10000) {
-            uint64_t *frame = (uint64_t *)rbp;
-            ctx->uc_mcontext.gregs[REG_RBP] = frame[0];
-            ctx->uc_mcontext.gregs[REG_RIP] = frame[1];
-            ctx->uc_mcontext.gregs[REG_RSP] = rbp + 16;
-        } else {
-            ctx->uc_mcontext.gregs[REG_RIP] = *(uint64_t *)rsp;
-            ctx->uc_mcontext.gregs[REG_RSP] = rsp + 8;
+/* ── policy blob: configuration without per-process parsing ────────── */
+/*
+ * steamfix.policy (see steamfix_policy.h), compiled from steamfix.conf,
+ * is mapped read-only once in init() and used in place. A blob that is
+ * missing, truncated or fails its checksum is ignored as a whole.
+ */
+static const struct steamfix_policy *policy = NULL;
+
+static int policy_valid(const struct steamfix_policy *p, size_t size) {
+    if (size < sizeof(*p) || p->magic != STEAMFIX_POLICY_MAGIC ||
+        p->version != STEAMFIX_POLICY_VERSION || p->size != size ||
+        p->checksum != steamfix_fnv1a(STEAMFIX_FNV_BASIS,
+                                      (const char *)p + STEAMFIX_POLICY_CHECKED_FROM,
+                                      size - STEAMFIX_POLICY_CHECKED_FROM))
+        return 0;
+    if (p->sites_bits &&
+        (p->sites_bits > 16 || p->sites_off % 8 || p->sites_off > size ||
+         (sizeof(struct steamfix_site) << p->sites_bits) > size - p->sites_off))
+        return 0;
+    if ((p->flags & STEAMFIX_POLICY_WEBHELPER_ARGS) &&
+        (p->webhelper_args_off >= size ||
+         !memchr((const char *)p + p->webhelper_args_off, 0, size - p->webhelper_args_off)))
+        return 0;
+    if ((p->flags & STEAMFIX_POLICY_TARGETS) &&
+        (p->targets_off >= size ||
+         !memchr((const char *)p + p->targets_off, 0, size - p->targets_off)))
+        return 0;
+    return 1;
+}
+
+/* dladdr() without libdl: the loaded object containing `data` */
+static int policy_find_self(struct dl_phdr_info *info, size_t size, void *data) {
+    const char **name = data;
+    (void)size;
+    for (unsigned i = 0; i < info->dlpi_phnum; i++) {
+        const Elf64_Phdr *ph = &info->dlpi_phdr[i];
+        uint64_t lo = info->dlpi_addr + ph->p_vaddr;
+        if (ph->p_type == PT_LOAD && (uint64_t)*name - lo < ph->p_memsz) {
+            *name = info->dlpi_name;
+            return 1;
         }
+    }
+    return 0;
+}
+
+/* The path this library was loaded from, NULL if unknown */
+static const char *self_object(void) {
+    static const char *name;
+    const char *self = __atomic_load_n(&name, __ATOMIC_ACQUIRE);
+    if (!self) {
+        self = (const char *)self_object;
+        if (dl_iterate_phdr(policy_find_self, &self) != 1 || !self)
+            return NULL;
+        __atomic_store_n(&name, self, __ATOMIC_RELEASE);
+    }
+    return self;
+}
+
+/* Path of `file` in the library's own directory, 0 if unknown */
+static int self_path(char *buf, size_t size, const char *file) {
+    const char *self = self_object(), *slash;
+    if (!self || !(slash = strrchr(self, '/')))
+        return 0;
+    int n = snprintf(buf, size, "%.*s/%s", (int)(slash - self), self, file);
+    return n > 0 && (size_t)n < size;
+}
+
+static void policy_load(void) {
+    char buf[512];
+    const char *path = getenv(STEAMFIX_POLICY_ENV);
+    if (!path) {
+        if (!self_path(buf, sizeof(buf), STEAMFIX_POLICY_FILE))
+            return;
+        path = buf;
+    }
+    if (!*path)
+        return;
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return;
+    struct stat st;
+    void *p = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(*policy) &&
+        st.st_size <= STEAMFIX_POLICY_MAX_SIZE)
+        p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED)
+        return;
+    if (!policy_valid(p, (size_t)st.st_size)) {
+        munmap(p, (size_t)st.st_size);
         return;
     }
+    policy = p;
+}
 
-    /* Non-NULL fault — genuine crash, restore default and re-raise */
-    struct sigaction sa = { .sa_handler = SIG_DFL };
-    sigaction(SIGSEGV, &sa, NULL);
-    handlers_locked = 0;
-    raise(SIGSEGV);
+static int policy_flag(uint32_t flag) {
+    return policy && (policy->flags & flag);
 }
 
-/* ── SIGTRAP/SIGILL: safety net for NOTREACHED/IMMEDIATE_CRASH ───── */
-static void crash_handler(int sig, siginfo_t *info, void *ucontext) {
-    (void)info;
-    ucontext_t *ctx = (ucontext_t *)ucontext;
-    uint64_t rip = ctx->uc_mcontext.gregs[REG_RIP];
-    uint64_t rbp = ctx->uc_mcontext.gregs[REG_RBP];
-    uint8_t *insn = (uint8_t *)rip;
+#ifndef STEAMFIX_MINIMAL
+/* The policy's steamwebhelper switches, or NULL if it doesn't set them */
+static const char *policy_webhelper_args(void) {
+    if (!policy_flag(STEAMFIX_POLICY_WEBHELPER_ARGS))
+        return NULL;
+    return (const char *)policy + policy->webhelper_args_off;
+}
+#endif
 
-    int is_crash = (insn[0] == 0xcc)                       /* int3  */
-                || (insn[0] == 0x0f && insn[1] == 0x0b);   /* ud2   */
+/* The policy's target programs, or NULL if it doesn't name them */
+static const char *policy_targets(void) {
+    if (!policy_flag(STEAMFIX_POLICY_TARGETS))
+        return NULL;
+    return (const char *)policy + policy->targets_off;
+}
 
-    if (is_crash && rbp > 0x10000) {
-        /*
-         * NOTREACHED stub layout:  push rbp; mov rbp,rsp; int3; ud2; int3
-         * When we land here the stub has set up its own frame.
-         * Returning to the direct caller (the function that called NOTREACHED)
-         * often causes infinite loops because that caller retries.
-         * Instead, skip TWO frames — return to the caller's caller.
-         */
-        uint64_t *stub_frame   = (uint64_t *)rbp;
-        uint64_t caller_rbp    = stub_frame[0];
-
-        if (caller_rbp > 0x10000) {
-            uint64_t *caller_frame = (uint64_t *)caller_rbp;
-            ctx->uc_mcontext.gregs[REG_RAX] = 0;
-            ctx->uc_mcontext.gregs[REG_RBP] = caller_frame[0];
-            ctx->uc_mcontext.gregs[REG_RIP] = caller_frame[1];
-            ctx->uc_mcontext.gregs[REG_RSP] = caller_rbp + 16;
-            return;
+/* ── telemetry: shared-memory event ring ───────────────────────────── */
+/*
+ * Every recovery decision, sigaction()/signal() lock-out and clone3
+ * denial is appended to a ring in a shared-memory segment (layout in
+ * steamfix_telemetry.h), one per Steam session. Recording is a fetch-add
+ * and a handful of atomic stores: no locks, no libc, no syscalls once
+ * the thread's tid is cached — safe and cheap from signal context.
+ * Zygote children inherit the mapping across fork; exec'd processes
+ * find the segment again through STEAMFIX_SESSION.
+ */
+static struct steamfix_telemetry *telemetry = NULL;
+static int      telemetry_owner = 0;    /* we created the session       */
+static uint32_t telemetry_pid   = 0;
+static uint32_t telemetry_gen   = 1;    /* bumped in every forked child */
+
+static __thread struct { uint32_t gen, tid; } telemetry_thread
+    __attribute__((tls_model("initial-exec")));
+
+static inline long raw_syscall0(long nr) {
+    long ret;
+    __asm__ volatile ("syscall" : "=a"(ret) : "a"(nr) : "rcx", "r11", "memory");
+    return ret;
+}
+
+static inline long raw_syscall3(long nr, long a1, long a2, long a3) {
+    long ret;
+    __asm__ volatile ("syscall" : "=a"(ret)
+                      : "a"(nr), "D"(a1), "S"(a2), "d"(a3)
+                      : "rcx", "r11", "memory");
+    return ret;
+}
+
+static inline long raw_syscall4(long nr, long a1, long a2, long a3, long a4) {
+    long ret;
+    register long r10 __asm__("r10") = a4;
+    __asm__ volatile ("syscall" : "=a"(ret)
+                      : "a"(nr), "D"(a1), "S"(a2), "d"(a3), "r"(r10)
+                      : "rcx", "r11", "memory");
+    return ret;
+}
+
+static inline long raw_syscall6(long nr, long a1, long a2, long a3,
+                                long a4, long a5, long a6) {
+    long ret;
+    register long r10 __asm__("r10") = a4;
+    register long r8 __asm__("r8") = a5;
+    register long r9 __asm__("r9") = a6;
+    __asm__ volatile ("syscall" : "=a"(ret)
+                      : "a"(nr), "D"(a1), "S"(a2), "d"(a3), "r"(r10), "r"(r8), "r"(r9)
+                      : "rcx", "r11", "memory");
+    return ret;
+}
+
+static uint32_t telemetry_tid(void) {
+    uint32_t gen = __atomic_load_n(&telemetry_gen, __ATOMIC_RELAXED);
+    if (telemetry_thread.gen != gen) {
+        telemetry_thread.tid = (uint32_t)raw_syscall0(SYS_gettid);
+        telemetry_thread.gen = gen;
+    }
+    return telemetry_thread.tid;
+}
+
+/* An event that names a program: `name` (up to 16 bytes of it) */
+static void telemetry_record_named(uint16_t kind, uint16_t path, int sig,
+                                   uint64_t rip, uint64_t addr,
+                                   const char *name, size_t len) {
+    struct steamfix_telemetry *t = __atomic_load_n(&telemetry, __ATOMIC_ACQUIRE);
+    if (!t)
+        return;
+
+    uint64_t comm[2] = { 0, 0 };
+    memcpy(comm, name, len < sizeof(comm) ? len : sizeof(comm));
+
+    uint64_t idx = __atomic_fetch_add(&t->head, 1, __ATOMIC_RELAXED);
+    struct steamfix_event *e = &t->events[idx & (STEAMFIX_TELEMETRY_EVENTS - 1)];
+
+    __atomic_store_n(&e->seq, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&e->tsc,  __rdtsc(), __ATOMIC_RELAXED);
+    __atomic_store_n(&e->rip,  rip, __ATOMIC_RELAXED);
+    __atomic_store_n(&e->addr, addr, __ATOMIC_RELAXED);
+    __atomic_store_n(&e->pid,  telemetry_pid, __ATOMIC_RELAXED);
+    __atomic_store_n(&e->tid,  telemetry_tid(), __ATOMIC_RELAXED);
+    __atomic_store_n(&e->kind, kind, __ATOMIC_RELAXED);
+    __atomic_store_n(&e->path, path, __ATOMIC_RELAXED);
+    __atomic_store_n(&e->sig,  (uint32_t)sig, __ATOMIC_RELAXED);
+    __atomic_store_n((uint64_t *)e->comm, comm[0], __ATOMIC_RELAXED);
+    __atomic_store_n((uint64_t *)e->comm + 1, comm[1], __ATOMIC_RELAXED);
+    __atomic_store_n(&e->seq,  idx + 1, __ATOMIC_RELEASE);
+}
+
+static void telemetry_record(uint16_t kind, uint16_t path, int sig,
+                             uint64_t rip, uint64_t addr) {
+    telemetry_record_named(kind, path, sig, rip, addr, "", 0);
+}
+
+/* Child of fork()/clone() without CLONE_VM: new pid, one thread, stale tids */
+static void telemetry_after_fork(void) {
+    uint32_t parent = telemetry_pid;
+    telemetry_pid = (uint32_t)getpid();
+    __atomic_add_fetch(&telemetry_gen, 1, __ATOMIC_RELAXED);
+    telemetry_record(STEAMFIX_EV_FORK, 0, 0, 0, parent);
+}
+
+static void telemetry_init(void) {
+    const char *env = getenv("STEAMFIX_TELEMETRY");
+    if (env ? env[0] == '0' : policy_flag(STEAMFIX_POLICY_TELEMETRY_OFF))
+        return;
+
+    telemetry_pid = (uint32_t)getpid();
+
+    unsigned long session = 0;
+    const char *s = getenv(STEAMFIX_SESSION_ENV);
+    if (s && *s) {
+        char *end;
+        session = strtoul(s, &end, 10);
+        if (*end)
+            session = 0;
+    }
+    if (!session) {
+        char buf[16];
+        session = telemetry_pid;
+        snprintf(buf, sizeof(buf), "%lu", session);
+        setenv(STEAMFIX_SESSION_ENV, buf, 1);
+        telemetry_owner = 1;
+    }
+
+    char path[64];
+    if (steamfix_telemetry_path(path, sizeof(path), getuid(), (unsigned)session))
+        return;
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC | O_NOFOLLOW, 0600);
+    if (fd < 0)
+        return;
+
+    /* /dev/shm is shared: a segment someone else created (or opened up)
+     * could be read or fed forged events, so only our own 0600 file goes */
+    size_t size = sizeof(struct steamfix_telemetry);
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+        st.st_uid != getuid() || (st.st_mode & 07777) != 0600 ||
+        ((size_t)st.st_size < size && ftruncate(fd, (off_t)size) != 0)) {
+        close(fd);
+        return;
+    }
+    struct steamfix_telemetry *t =
+        mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (t == MAP_FAILED)
+        return;
+
+    uint32_t unclaimed = 0;
+    if (__atomic_compare_exchange_n(&t->init, &unclaimed, 1, 0,
+                                    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        t->version     = STEAMFIX_TELEMETRY_VERSION;
+        t->capacity    = STEAMFIX_TELEMETRY_EVENTS;
+        t->session     = (uint32_t)session;
+        t->created_tsc = __rdtsc();
+        t->created_ns  = (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+        __atomic_store_n(&t->magic, STEAMFIX_TELEMETRY_MAGIC, __ATOMIC_RELEASE);
+    } else {
+        /* Another process is initialising the header right now */
+        for (int i = 0; i < 1000 &&
+             __atomic_load_n(&t->magic, __ATOMIC_ACQUIRE) != STEAMFIX_TELEMETRY_MAGIC; i++)
+            sched_yield();
+    }
+
+    if (t->magic != STEAMFIX_TELEMETRY_MAGIC ||
+        t->version != STEAMFIX_TELEMETRY_VERSION) {
+        munmap(t, size);
+        return;
+    }
+    pthread_atfork(NULL, NULL, telemetry_after_fork);
+    __atomic_store_n(&telemetry, t, __ATOMIC_RELEASE);
+}
+
+/* The process that started the session removes the segment on exit */
+__attribute__((destructor))
+static void telemetry_fini(void) {
+    if (!telemetry_owner || telemetry_pid != (uint32_t)getpid())
+        return;
+    char path[64];
+    struct steamfix_telemetry *t = telemetry;
+    if (t && steamfix_telemetry_path(path, sizeof(path), getuid(), t->session) == 0)
+        unlink(path);
+}
+
+/* ── fault-site profile: what worked last time ─────────────────────── */
+/*
+ * Which recovery strategy (storm level) works at a site is the same from
+ * one run to the next until the code changes, yet every process learns
+ * it again by trial and error — and after each Steam update it's the
+ * respawns that teach it. So it's remembered, in a table shared by all
+ * processes and all runs: a file in $XDG_CACHE_HOME/steamfix/ named
+ * after libcef's build-id (the program's, without libcef), mapped
+ * MAP_SHARED so updates are plain atomics, safe from signal context, and
+ * survive the process dying right after.
+ *
+ * Per site and level it counts the processes that tried the level and
+ * how many of those it failed: the site stormed on, or the process went
+ * down with an unrecovered fault within PROFILE_BLAME_NS of recovering
+ * there. A site starts at the lowest level that has failed in at most
+ * half its tries, so a known-good strategy is used from the first fault
+ * and a known-bad one is skipped at once. Only that starting level is
+ * preloaded: the site still goes through the storm breaker like any
+ * other, which is what lets a known-good site escalate when it stops
+ * being good. STEAMFIX_PROFILE=0 turns it off.
+ */
+#define PROFILE_MAGIC       0x31304f5250584653ull  /* "SFXPRO01" */
+#define PROFILE_VERSION     1
+#define PROFILE_SLOTS       1024                /* power of two          */
+#define PROFILE_PROBE       8
+#define PROFILE_LEVELS      2                   /* the ones that recover */
+#define PROFILE_BLAME_NS    10000000000ull      /* 10 s                  */
+
+struct profile_site {
+    uint64_t key;               /* module, offset and kind mixed; 0 = free */
+    uint32_t tries[PROFILE_LEVELS];
+    uint32_t fails[PROFILE_LEVELS];
+};
+
+struct profile {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t init;              /* claimed by the process writing the header */
+    uint32_t slots;
+    uint32_t reserved[11];
+    struct profile_site site[PROFILE_SLOTS];
+};
+
+static struct profile *profile = NULL;
+
+/* <base>/steamfix/<file> under $XDG_CACHE_HOME or ~/.cache, 0 if neither */
+static int cache_path(char *path, size_t size, const char *file, int mkdirs) {
+    const char *base = getenv("XDG_CACHE_HOME"), *sub = "";
+    if (!base || base[0] != '/') {
+        base = getenv("HOME");
+        sub = "/.cache";
+        if (!base || base[0] != '/')
+            return 0;
+    }
+    int n = snprintf(path, size, "%s%s/steamfix", base, sub);
+    if (n <= 0 || (size_t)n >= size)
+        return 0;
+    if (mkdirs) {
+        if (*sub) {
+            path[n - 9] = 0;
+            mkdir(path, 0700);
+            path[n - 9] = '/';
         }
+        mkdir(path, 0700);
+    }
+    n = snprintf(path + n, size - (size_t)n, "/%s", file);
+    return n > 0 && (size_t)n < size;
+}
+
+static void profile_init(uint64_t build) {
+    const char *opt = getenv("STEAMFIX_PROFILE");
+    if ((opt && opt[0] == '0') || !build)
+        return;
+    char file[32], path[512];
+    snprintf(file, sizeof(file), "profile-%016llx", (unsigned long long)build);
+    if (!cache_path(path, sizeof(path), file, 1))
+        return;
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC | O_NOFOLLOW, 0600);
+    if (fd < 0)
+        return;
 
-        /* Single-frame fallback */
-        ctx->uc_mcontext.gregs[REG_RAX] = 0;
-        ctx->uc_mcontext.gregs[REG_RBP] = caller_rbp;
-        ctx->uc_mcontext.gregs[REG_RIP] = stub_frame[1];
-        ctx->uc_mcontext.gregs[REG_RSP] = rbp + 16;
+    struct stat st;
+    if (fstat(fd, &st) != 0 ||
+        ((size_t)st.st_size < sizeof(*profile) && ftruncate(fd, sizeof(*profile)) != 0)) {
+        close(fd);
         return;
     }
+    struct profile *p = mmap(NULL, sizeof(*p), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED)
+        return;
 
-    /* Not a crash stub — restore default */
-    struct sigaction sa = { .sa_handler = SIG_DFL };
-    sigaction(sig, &sa, NULL);
-    handlers_locked = 0;
-    raise(sig);
+    uint32_t unclaimed = 0;
+    if (__atomic_compare_exchange_n(&p->init, &unclaimed, 1, 0,
+                                    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        p->version = PROFILE_VERSION;
+        p->slots = PROFILE_SLOTS;
+        __atomic_store_n(&p->magic, PROFILE_MAGIC, __ATOMIC_RELEASE);
+    } else {
+        for (int i = 0; i < 1000 &&
+             __atomic_load_n(&p->magic, __ATOMIC_ACQUIRE) != PROFILE_MAGIC; i++)
+            sched_yield();
+    }
+    if (p->magic != PROFILE_MAGIC || p->version != PROFILE_VERSION ||
+        p->slots != PROFILE_SLOTS) {
+        munmap(p, sizeof(*p));
+        return;
+    }
+    __atomic_store_n(&profile, p, __ATOMIC_RELEASE);
 }
 
-/* ── sigaction interception: prevent crashpad from overriding us ──── */
+/* The entry for a fault of `kind` at `offset` in `module`, claimed if new */
+static struct profile_site *profile_site(uint64_t module, uint64_t offset, uint32_t kind) {
+    struct profile *p = __atomic_load_n(&profile, __ATOMIC_ACQUIRE);
+    if (!p)
+        return NULL;
+    uint64_t key = ((module ^ offset * 0x9E3779B97F4A7C15ull) * 0xff51afd7ed558ccdull
+                    ^ kind) | 1;
+    for (unsigned i = 0; i < PROFILE_PROBE; i++) {
+        struct profile_site *e = &p->site[(key + i) & (PROFILE_SLOTS - 1)];
+        uint64_t k = __atomic_load_n(&e->key, __ATOMIC_ACQUIRE);
+        if (k == key)
+            return e;
+        if (k == 0 &&
+            (__atomic_compare_exchange_n(&e->key, &k, key, 0,
+                                         __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) || k == key))
+            return e;
+    }
+    return NULL;
+}
+
+/* The first level not known to fail at `e` */
+static int profile_start(const struct profile_site *e) {
+    int level = 0;
+    while (e && level < PROFILE_LEVELS) {
+        uint32_t tries = __atomic_load_n(&e->tries[level], __ATOMIC_RELAXED);
+        uint32_t fails = __atomic_load_n(&e->fails[level], __ATOMIC_RELAXED);
+        if (fails * 2 <= tries)
+            break;
+        level++;
+    }
+    return level;
+}
+
+static void profile_count(uint32_t *counter, int level) {
+    if (level < PROFILE_LEVELS)
+        __atomic_add_fetch(&counter[level], 1, __ATOMIC_RELAXED);
+}
+
+/* ── fault storm breaker ───────────────────────────────────────────── */
 /*
- * Chrome's crashpad installs its own SIGSEGV/SIGTRAP/SIGILL handlers
- * on startup, overriding ours. We intercept sigaction() and silently
- * refuse to replace our handlers for those three signals.
+ * A recovery can resume the caller in code that faults again right away,
+ * which turns the handler into a busy loop that recovers the same site
+ * thousands of times a second. We keep a small lock-free table of recent
+ * fault sites with a per-window hit counter. A site that goes over the
+ * threshold is escalated: first to an alternate unwind (one frame further
+ * up), then to SIG_DFL + re-raise. Everything here is async-signal-safe:
+ * atomics on a static table plus clock_gettime().
  */
-typedef int (*real_sigaction_t)(int, const struct sigaction *, struct sigaction *);
-static real_sigaction_t real_sigaction_fn = NULL;
+#define STORM_SLOTS      64                 /* power of two              */
+#define STORM_PROBE      4                  /* linear-probe distance     */
+#define STORM_WINDOW_NS  1000000000ull      /* 1 s                       */
+#define STORM_THRESHOLD  512                /* default recoveries per window */
+#define STORM_BATCH      16                 /* per-thread hits per shared add */
 
-int sigaction(int signum, const struct sigaction *act, struct sigaction *oldact) {
-    if (!real_sigaction_fn)
-        real_sigaction_fn = (real_sigaction_t)dlsym(RTLD_NEXT, "sigaction");
+enum { STORM_NORMAL, STORM_ALTERNATE, STORM_GIVE_UP };
 
-    if (handlers_locked && act != NULL &&
-        (signum == SIGSEGV || signum == SIGTRAP || signum == SIGILL)) {
-        if (oldact)
-            real_sigaction_fn(signum, NULL, oldact);
-        return 0;   /* pretend we set it */
+/*
+ * One cache line per site: threads faulting at different sites never
+ * share a line. Threads faulting at the same one count their hits in
+ * storm_local and add them to `hits` STORM_BATCH at a time, so the line
+ * is only written once per batch and stays shared-clean in between.
+ */
+static struct storm_site {
+    uint64_t key;               /* mixed rip/fault address, 0 = free */
+    uint64_t window_ns;         /* start of the current window       */
+    uint32_t hits;              /* recoveries in the current window  */
+    uint32_t level;             /* STORM_*                           */
+    struct profile_site *profile;   /* where its levels are scored   */
+} __attribute__((aligned(64))) storm_sites[STORM_SLOTS];
+
+static __thread struct { uint32_t key, pending; } storm_local[STORM_SLOTS]
+    __attribute__((tls_model("initial-exec")));
+
+/* STEAMFIX_STORM_THRESHOLD overrides the default; 0 never escalates */
+static uint32_t storm_threshold = STORM_THRESHOLD;
+
+static uint64_t storm_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* Record a recovery at (rip, addr) and return the strategy level to use */
+static int storm_level(uint64_t rip, uint64_t addr, struct profile_site *prof) {
+    uint64_t key = ((rip * 0x9E3779B97F4A7C15ull) ^ addr) | 1;
+    uint64_t now = storm_now_ns();
+    struct storm_site *site = NULL;
+
+    for (unsigned i = 0; i < STORM_PROBE && !site; i++) {
+        struct storm_site *s = &storm_sites[(key + i) & (STORM_SLOTS - 1)];
+        uint64_t k = __atomic_load_n(&s->key, __ATOMIC_ACQUIRE);
+        if (k == key) {
+            site = s;
+            break;
+        }
+        /* Take over a free slot, or one that has been quiet for a while */
+        if (k != 0 && now - __atomic_load_n(&s->window_ns, __ATOMIC_RELAXED)
+                      < 2 * STORM_WINDOW_NS)
+            continue;
+        if (__atomic_compare_exchange_n(&s->key, &k, key, 0,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            /* Known-bad levels are skipped from the first fault */
+            int start = profile_start(prof);
+            __atomic_store_n(&s->window_ns, now, __ATOMIC_RELAXED);
+            __atomic_store_n(&s->hits, 0, __ATOMIC_RELAXED);
+            __atomic_store_n(&s->level, (uint32_t)start, __ATOMIC_RELAXED);
+            __atomic_store_n(&s->profile, prof, __ATOMIC_RELEASE);
+            if (prof)
+                profile_count(prof->tries, start);
+            site = s;
+        } else if (k == key) {
+            site = s;
+        }
+    }
+    if (!site)
+        return STORM_NORMAL;    /* table saturated: don't punish what we can't track */
+
+    uint64_t start = __atomic_load_n(&site->window_ns, __ATOMIC_RELAXED);
+    if (now - start > STORM_WINDOW_NS &&
+        __atomic_compare_exchange_n(&site->window_ns, &start, now, 0,
+                                    __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        __atomic_store_n(&site->hits, 0, __ATOMIC_RELAXED);
+
+    /* Thresholds too low to batch under are counted exactly */
+    uint32_t level = __atomic_load_n(&site->level, __ATOMIC_RELAXED);
+    unsigned batch = storm_threshold >= 8 * STORM_BATCH ? STORM_BATCH : 1;
+    __typeof__(storm_local[0]) *local = &storm_local[site - storm_sites];
+    if (local->key != (uint32_t)key) {
+        local->key = (uint32_t)key;
+        local->pending = 0;
     }
-    return real_sigaction_fn(signum, act, oldact);
+    if (++local->pending < batch)
+        return (int)level;
+    uint32_t hits = __atomic_add_fetch(&site->hits, local->pending, __ATOMIC_RELAXED);
+    local->pending = 0;
+    if (hits > storm_threshold && level < STORM_GIVE_UP &&
+        __atomic_compare_exchange_n(&site->level, &level, level + 1, 0,
+                                    __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        __atomic_store_n(&site->hits, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&site->window_ns, now, __ATOMIC_RELAXED);
+        if ((prof = __atomic_load_n(&site->profile, __ATOMIC_ACQUIRE)) != NULL) {
+            profile_count(prof->fails, (int)level);
+            profile_count(prof->tries, (int)level + 1);
+        }
+        level++;
+    }
+    return (int)level;
 }
 
-typedef void (*sighandler_t)(int);
-sighandler_t signal(int signum, sighandler_t handler) {
-    if (handlers_locked &&
-        (signum == SIGSEGV || signum == SIGTRAP || signum == SIGILL))
-        return SIG_DFL;
+/* The process is going down: what it recovered lately didn't save it */
+static void storm_blame(void) {
+    uint64_t now = storm_now_ns();
+    for (unsigned i = 0; i < STORM_SLOTS; i++) {
+        struct storm_site *s = &storm_sites[i];
+        if (!__atomic_load_n(&s->key, __ATOMIC_ACQUIRE) ||
+            now - __atomic_load_n(&s->window_ns, __ATOMIC_RELAXED) > PROFILE_BLAME_NS)
+            continue;
+        struct profile_site *prof = __atomic_exchange_n(&s->profile, NULL, __ATOMIC_ACQ_REL);
+        if (prof)
+            profile_count(prof->fails, (int)__atomic_load_n(&s->level, __ATOMIC_RELAXED));
+    }
+}
 
-    struct sigaction sa_old, sa_new;
-    memset(&sa_new, 0, sizeof(sa_new));
-    sa_new.sa_handler = handler;
-    sigemptyset(&sa_new.sa_mask);
-    if (!real_sigaction_fn)
-        real_sigaction_fn = (real_sigaction_t)dlsym(RTLD_NEXT, "sigaction");
-    real_sigaction_fn(signum, &sa_new, &sa_old);
-    return sa_old.sa_handler;
+/* ── module map: fault attribution without the loader ──────────────── */
+/*
+ * dladdr() and dl_iterate_phdr() take the loader lock, so a fault inside
+ * the loader (or a handler racing a dlopen()) could deadlock on them.
+ * Instead the address ranges of every loaded object are collected up
+ * front, in init() and around dlopen()/dlclose(), into a sorted array
+ * the handlers binary-search without locks.
+ *
+ * Updates are RCU-style: the writer builds a new array, swaps the pointer
+ * in, flips the reader epoch and frees the old array once every reader
+ * that entered under the old epoch has left. Readers count themselves in
+ * one of MODULE_STRIPES padded counters per epoch, picked by thread, so
+ * concurrent faults don't all bounce one line; the writer sums them.
+ */
+#define ELF_RANGES      16
+#define MODULE_STRIPES  16              /* power of two */
+
+struct module_range {
+    uint64_t lo, hi;            /* span of the PT_LOAD segments          */
+    uint64_t bias;              /* dlpi_addr: ELF vaddr + bias = address */
+    uint64_t name;              /* FNV-1a of DT_SONAME, else file name   */
+    uint64_t build_id;          /* FNV-1a of the build-id hex, 0 if none */
+    uint64_t eh_hdr;            /* .eh_frame_hdr, base of its table offsets */
+    uint64_t eh_table;          /* its sorted (pc, FDE) table, sdata4 pairs */
+    uint64_t eh_count;          /* entries in eh_table, 0 if unusable       */
+    uint64_t dynamic;           /* PT_DYNAMIC, 0 if unknown                 */
+};
+
+struct module_map {
+    size_t count;
+    struct module_range mod[];
+};
+
+static struct module_map *module_map = NULL;
+static unsigned module_epoch = 0;
+static struct {
+    unsigned n;
+} __attribute__((aligned(64))) module_readers[2][MODULE_STRIPES];
+static pthread_mutex_t module_lock = PTHREAD_MUTEX_INITIALIZER;
+static unsigned long long module_adds, module_subs;    /* last rebuild's */
+static char module_exe[256];    /* dl_iterate_phdr names it ""           */
+
+/* Readable spans of an object we don't trust to be fully mapped */
+struct elf_ranges {
+    unsigned n;
+    struct { uint64_t lo, hi; } r[ELF_RANGES];
+};
+
+static int elf_readable(const struct elf_ranges *rs, uint64_t p, uint64_t len) {
+    if (!rs)
+        return 1;
+    for (unsigned i = 0; i < rs->n; i++)
+        if (p >= rs->r[i].lo && len <= rs->r[i].hi - p)
+            return 1;
+    return 0;
+}
+
+static const char *elf_basename(const char *path, size_t *len) {
+    const char *name = strrchr(path, '/');
+    name = name ? name + 1 : path;
+    *len = strlen(name);
+    if (*len > 10 && strcmp(name + *len - 10, " (deleted)") == 0)
+        *len -= 10;
+    return name;
 }
 
-/* ── clone3 interception: safety net for seccomp ─────────────────── */
 /*
- * Kernel 6.13+ prefers clone3() but Chrome 126's seccomp sandbox
- * blocks it. Returning ENOSYS forces glibc to fall back to clone().
+ * SONAME and build-id hashes of the object at `bias`, from its program
+ * headers. With `rs`, every read is checked against it first.
  */
-typedef long (*syscall_fn_t)(long, ...);
-static syscall_fn_t real_syscall = NULL;
+static void elf_identify(uint64_t bias, const Elf64_Phdr *ph, unsigned phnum,
+                         const struct elf_ranges *rs, struct module_range *mod) {
+    mod->build_id = 0;
+    for (unsigned i = 0; i < phnum; i++) {
+        if (ph[i].p_type == PT_NOTE && !mod->build_id) {
+            uint64_t p = bias + ph[i].p_vaddr, end = p + ph[i].p_memsz;
+            if (!elf_readable(rs, p, ph[i].p_memsz))
+                continue;
+            while (p + sizeof(Elf64_Nhdr) <= end) {
+                const Elf64_Nhdr *nh = (const Elf64_Nhdr *)p;
+                uint64_t name = p + sizeof(*nh);
+                uint64_t desc = name + ((nh->n_namesz + 3) & ~3u);
+                uint64_t next = desc + ((nh->n_descsz + 3) & ~3u);
+                if (next > end)
+                    break;
+                if (nh->n_type == NT_GNU_BUILD_ID && nh->n_namesz == 4 &&
+                    memcmp((const void *)name, "GNU", 4) == 0) {
+                    mod->build_id = steamfix_fnv1a_hex(STEAMFIX_FNV_BASIS,
+                                                       (const void *)desc, nh->n_descsz);
+                    break;
+                }
+                p = next;
+            }
+        } else if (ph[i].p_type == PT_DYNAMIC) {
+            const Elf64_Dyn *dyn = (const Elf64_Dyn *)(bias + ph[i].p_vaddr);
+            size_t ndyn = ph[i].p_memsz / sizeof(*dyn);
+            if (!elf_readable(rs, (uint64_t)dyn, ndyn * sizeof(*dyn)))
+                continue;
+            uint64_t strtab = 0, soname = UINT64_MAX;
+            for (size_t j = 0; j < ndyn && dyn[j].d_tag != DT_NULL; j++) {
+                if (dyn[j].d_tag == DT_STRTAB)
+                    strtab = dyn[j].d_un.d_ptr;
+                else if (dyn[j].d_tag == DT_SONAME)
+                    soname = dyn[j].d_un.d_val;
+            }
+            /* ld.so relocates DT_STRTAB in place; the vDSO's isn't */
+            if (strtab && strtab < bias)
+                strtab += bias;
+            if (!strtab || soname == UINT64_MAX)
+                continue;
+            const char *s = (const char *)(strtab + soname);
+            size_t len = 0;
+            while (len < 256 && elf_readable(rs, (uint64_t)s + len, 1) && s[len])
+                len++;
+            if (len && len < 256)
+                mod->name = steamfix_fnv1a(STEAMFIX_FNV_BASIS, s, len);
+        }
+    }
+}
+
+/*
+ * The binary-search table of the object's PT_GNU_EH_FRAME, if it has the
+ * layout every linker emits: version 1, datarel sdata4 (pc, FDE) pairs.
+ */
+static void module_eh_frame(const struct dl_phdr_info *info, struct module_range *mod) {
+    mod->eh_hdr = mod->eh_table = mod->eh_count = 0;
+    for (unsigned i = 0; i < info->dlpi_phnum; i++) {
+        const Elf64_Phdr *ph = &info->dlpi_phdr[i];
+        if (ph->p_type != PT_GNU_EH_FRAME || ph->p_memsz < 12)
+            continue;
+        const uint8_t *hdr = (const uint8_t *)(info->dlpi_addr + ph->p_vaddr);
+        /* version, eh_frame_ptr_enc, fde_count_enc (udata4), table_enc */
+        if (hdr[0] != 1 || hdr[2] != 0x03 || hdr[3] != 0x3b)
+            return;
+        size_t ptr_len;
+        switch (hdr[1] & 0x0f) {
+        case 0x03: case 0x0b: ptr_len = 4; break;
+        case 0x00: case 0x04: case 0x0c: ptr_len = 8; break;
+        default: return;
+        }
+        uint32_t count;
+        if (ph->p_memsz < 8 + ptr_len)
+            return;
+        memcpy(&count, hdr + 4 + ptr_len, 4);
+        if (count > (ph->p_memsz - 8 - ptr_len) / 8)
+            return;
+        mod->eh_hdr = (uint64_t)hdr;
+        mod->eh_table = (uint64_t)(hdr + 8 + ptr_len);
+        mod->eh_count = count;
+        return;
+    }
+}
 
-long syscall(long number, ...) {
-    if (!real_syscall)
-        real_syscall = (syscall_fn_t)dlsym(RTLD_NEXT, "syscall");
+struct module_build {
+    struct module_map *map;
+    size_t cap;
+    unsigned long long adds, subs;
+};
 
-    if (number == SYS_clone3) {
-        errno = ENOSYS;
-        return -1;
+static int module_collect(struct dl_phdr_info *info, size_t size, void *data) {
+    struct module_build *b = data;
+    (void)size;
+    b->adds = info->dlpi_adds;
+    b->subs = info->dlpi_subs;
+
+    uint64_t lo = UINT64_MAX, hi = 0;
+    for (unsigned i = 0; i < info->dlpi_phnum; i++) {
+        const Elf64_Phdr *ph = &info->dlpi_phdr[i];
+        if (ph->p_type != PT_LOAD)
+            continue;
+        if (info->dlpi_addr + ph->p_vaddr < lo)
+            lo = info->dlpi_addr + ph->p_vaddr;
+        if (info->dlpi_addr + ph->p_vaddr + ph->p_memsz > hi)
+            hi = info->dlpi_addr + ph->p_vaddr + ph->p_memsz;
     }
+    if (lo >= hi)
+        return 0;
 
-    va_list ap;
-    va_start(ap, number);
-    long a1 = va_arg(ap, long);
-    long a2 = va_arg(ap, long);
-    long a3 = va_arg(ap, long);
-    long a4 = va_arg(ap, long);
-    long a5 = va_arg(ap, long);
-    long a6 = va_arg(ap, long);
-    va_end(ap);
-    return real_syscall(number, a1, a2, a3, a4, a5, a6);
+    if (b->map->count == b->cap) {
+        size_t cap = b->cap * 2;
+        struct module_map *m = realloc(b->map, sizeof(*m) + cap * sizeof(m->mod[0]));
+        if (!m)
+            return 1;
+        b->map = m;
+        b->cap = cap;
+    }
+    struct module_range *mod = &b->map->mod[b->map->count++];
+    mod->lo = lo;
+    mod->hi = hi;
+    mod->bias = info->dlpi_addr;
+
+    size_t len;
+    const char *path = info->dlpi_name && *info->dlpi_name ? info->dlpi_name : module_exe;
+    const char *name = elf_basename(path, &len);
+    mod->name = steamfix_fnv1a(STEAMFIX_FNV_BASIS, name, len);
+    elf_identify(info->dlpi_addr, info->dlpi_phdr, info->dlpi_phnum, NULL, mod);
+    module_eh_frame(info, mod);
+    mod->dynamic = 0;
+    for (unsigned i = 0; i < info->dlpi_phnum; i++)
+        if (info->dlpi_phdr[i].p_type == PT_DYNAMIC)
+            mod->dynamic = info->dlpi_addr + info->dlpi_phdr[i].p_vaddr;
+    return 0;
 }
 
-/* ── constructor ─────────────────────────────────────────────────── */
-__attribute__((constructor(101)))
-static void init(void) {
-    if (!real_sigaction_fn)
-        real_sigaction_fn = (real_sigaction_t)dlsym(RTLD_NEXT, "sigaction");
+#ifndef STEAMFIX_MINIMAL
+/*
+ * dl_iterate_phdr() only lists its caller's namespace, and under LD_AUDIT
+ * that is ours. The application's objects are walked from the link map
+ * la_objopen() saw instead, as dl_iterate_phdr() would list them: each
+ * one's program headers through its ELF header, which the first PT_LOAD
+ * maps at l_addr, and the main program's from the aux vector. Called
+ * with the loader's lock held (la_activity()) or before anything else
+ * can load.
+ */
+static int module_collect_audit(struct module_build *b) {
+    for (struct link_map *lm = audit_base; lm; lm = lm->l_next) {
+        struct dl_phdr_info info;
+        memset(&info, 0, sizeof(info));
+        info.dlpi_addr = lm->l_addr;
+        info.dlpi_name = lm->l_name;
+        info.dlpi_adds = b->adds;
+        info.dlpi_subs = b->subs;
+        if (lm == audit_base) {
+            info.dlpi_phdr = (const ElfW(Phdr) *)getauxval(AT_PHDR);
+            info.dlpi_phnum = (ElfW(Half))getauxval(AT_PHNUM);
+        } else {
+            const ElfW(Ehdr) *eh = (const ElfW(Ehdr) *)lm->l_addr;
+            if (!eh || memcmp(eh->e_ident, ELFMAG, SELFMAG) != 0)
+                continue;
+            info.dlpi_phdr = (const ElfW(Phdr) *)(lm->l_addr + eh->e_phoff);
+            info.dlpi_phnum = eh->e_phnum;
+        }
+        if (info.dlpi_phdr && module_collect(&info, sizeof(info), b) != 0)
+            return 1;
+    }
+    return 0;
+}
+#endif
 
-    struct sigaction sa;
-    memset(&sa, 0, sizeof(sa));
-    sa.sa_flags = SA_SIGINFO | SA_NODEFER;
-    sigemptyset(&sa.sa_mask);
+static int module_cmp(const void *a, const void *b) {
+    const struct module_range *x = a, *y = b;
+    return (x->lo > y->lo) - (x->lo < y->lo);
+}
+
+static int module_counters(struct dl_phdr_info *info, size_t size, void *data) {
+    struct module_build *b = data;
+    (void)size;
+    b->adds = info->dlpi_adds;
+    b->subs = info->dlpi_subs;
+    return 1;
+}
+
+static void site_cache_flush(void);
+
+/* Rebuild and publish the map if objects were loaded or unloaded */
+static void module_map_update(void) {
+    struct module_build b = { 0 };
+    pthread_mutex_lock(&module_lock);
+    dl_iterate_phdr(module_counters, &b);
+    if (module_map && b.adds == module_adds && b.subs == module_subs) {
+        pthread_mutex_unlock(&module_lock);
+        return;
+    }
+
+    b.cap = 64;
+    b.map = malloc(sizeof(*b.map) + b.cap * sizeof(b.map->mod[0]));
+    if (!b.map) {
+        pthread_mutex_unlock(&module_lock);
+        return;
+    }
+    b.map->count = 0;
+#ifndef STEAMFIX_MINIMAL
+    int failed = audit_base ? module_collect_audit(&b) : dl_iterate_phdr(module_collect, &b);
+#else
+    int failed = dl_iterate_phdr(module_collect, &b);
+#endif
+    if (failed) {
+        free(b.map);
+        pthread_mutex_unlock(&module_lock);
+        return;
+    }
+    qsort(b.map->mod, b.map->count, sizeof(b.map->mod[0]), module_cmp);
+    module_adds = b.adds;
+    module_subs = b.subs;
+
+    struct module_map *old = __atomic_exchange_n(&module_map, b.map, __ATOMIC_SEQ_CST);
+    unsigned epoch = __atomic_fetch_xor(&module_epoch, 1, __ATOMIC_SEQ_CST);
+    for (unsigned i = 0; i < MODULE_STRIPES; i++)
+        while (__atomic_load_n(&module_readers[epoch][i].n, __ATOMIC_SEQ_CST))
+            sched_yield();
+    free(old);
+    /* Verdicts for addresses that now belong to something else */
+    site_cache_flush();
+    pthread_mutex_unlock(&module_lock);
+}
+
+/*
+ * This thread's reader counter under the current epoch, now entered. If
+ * the epoch flipped between reading it and counting ourselves in, the
+ * writer that flipped it may not have waited for us, and the next one
+ * only waits on the other epoch: count ourselves in again under the new
+ * one, so whatever map we then load stays until we leave.
+ */
+static unsigned *module_enter(void) {
+    static __thread char here __attribute__((tls_model("initial-exec")));
+    unsigned stripe = (unsigned)(((uintptr_t)&here * 0x9E3779B97F4A7C15ull) >> 60)
+                      & (MODULE_STRIPES - 1);
+    for (;;) {
+        unsigned epoch = __atomic_load_n(&module_epoch, __ATOMIC_SEQ_CST);
+        unsigned *n = &module_readers[epoch][stripe].n;
+        __atomic_add_fetch(n, 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&module_epoch, __ATOMIC_SEQ_CST) == epoch)
+            return n;
+        __atomic_sub_fetch(n, 1, __ATOMIC_SEQ_CST);
+    }
+}
+
+static void module_leave(unsigned *n) {
+    __atomic_sub_fetch(n, 1, __ATOMIC_SEQ_CST);
+}
+
+/* The map entry containing `addr`; lock-free, safe from signal context */
+static int module_lookup(uint64_t addr, struct module_range *out) {
+    unsigned *reader = module_enter();
+
+    int found = 0;
+    const struct module_map *m = __atomic_load_n(&module_map, __ATOMIC_SEQ_CST);
+    if (m) {
+        size_t lo = 0, hi = m->count;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (m->mod[mid].lo <= addr)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        if (lo && addr < m->mod[lo - 1].hi) {
+            *out = m->mod[lo - 1];
+            found = 1;
+        }
+    }
+    module_leave(reader);
+    return found;
+}
+
+/* Build-id hash of the loaded module named `name` (FNV-1a), 0 if none */
+static uint64_t module_build_id(uint64_t name) {
+    unsigned *reader = module_enter();
+
+    uint64_t id = 0;
+    const struct module_map *m = __atomic_load_n(&module_map, __ATOMIC_SEQ_CST);
+    for (size_t i = 0; m && i < m->count && !id; i++)
+        if (m->mod[i].name == name)
+            id = m->mod[i].build_id;
+    module_leave(reader);
+    return id;
+}
+
+/*
+ * The function of `mod`'s dynamic symbol table that contains `addr`, as
+ * steamfix_site_symbol() names it, or 0. Reads only the mapped object.
+ */
+static uint64_t module_symbol(const struct module_range *mod, uint64_t addr) {
+    if (!mod->dynamic)
+        return 0;
+    uint64_t symtab = 0, strtab = 0, strsz = 0, hash = 0, gnu_hash = 0;
+    for (const Elf64_Dyn *d = (const Elf64_Dyn *)mod->dynamic; d->d_tag != DT_NULL; d++) {
+        switch (d->d_tag) {
+        case DT_SYMTAB:   symtab = d->d_un.d_ptr; break;
+        case DT_STRTAB:   strtab = d->d_un.d_ptr; break;
+        case DT_STRSZ:    strsz = d->d_un.d_val; break;
+        case DT_HASH:     hash = d->d_un.d_ptr; break;
+        case DT_GNU_HASH: gnu_hash = d->d_un.d_ptr; break;
+        }
+    }
+    /* Relocated in place by ld.so, except in the vDSO */
+    uint64_t *ptrs[] = { &symtab, &strtab, &hash, &gnu_hash };
+    for (unsigned i = 0; i < 4; i++)
+        if (*ptrs[i] && *ptrs[i] < mod->bias)
+            *ptrs[i] += mod->bias;
+    if (!symtab || !strtab)
+        return 0;
+
+    /* The symbol count: DT_HASH has it, DT_GNU_HASH's last chain ends it */
+    uint32_t count = 0;
+    if (hash) {
+        count = ((const uint32_t *)hash)[1];
+    } else if (gnu_hash) {
+        const uint32_t *h = (const uint32_t *)gnu_hash;
+        uint32_t nbuckets = h[0], symoffset = h[1];
+        const uint32_t *buckets = h + 4 + (size_t)h[2] * 2;      /* 64-bit bloom words */
+        const uint32_t *chain = buckets + nbuckets;
+        uint32_t last = 0;
+        for (uint32_t b = 0; b < nbuckets; b++)
+            if (buckets[b] > last)
+                last = buckets[b];
+        if (last < symoffset) {
+            count = symoffset;
+        } else {
+            while (!(chain[last - symoffset] & 1))
+                last++;
+            count = last + 1;
+        }
+    }
+
+    uint64_t off = addr - mod->bias;
+    const Elf64_Sym *sym = (const Elf64_Sym *)symtab;
+    for (uint32_t i = 1; i < count; i++) {
+        if (ELF64_ST_TYPE(sym[i].st_info) != STT_FUNC || sym[i].st_shndx == SHN_UNDEF ||
+            off - sym[i].st_value >= sym[i].st_size || sym[i].st_name >= strsz)
+            continue;
+        const char *name = (const char *)strtab + sym[i].st_name;
+        size_t len = 0;
+        while (sym[i].st_name + len < strsz && name[len])
+            len++;
+        return steamfix_site_symbol(name, len);
+    }
+    return 0;
+}
+
+static void module_fork_prepare(void) { pthread_mutex_lock(&module_lock); }
+static void module_fork_done(void)    { pthread_mutex_unlock(&module_lock); }
+
+static void module_exe_init(void) {
+    ssize_t n = readlink("/proc/self/exe", module_exe, sizeof(module_exe) - 1);
+    module_exe[n > 0 ? n : 0] = 0;
+}
+
+static void module_map_init(void) {
+    pthread_atfork(module_fork_prepare, module_fork_done, module_fork_done);
+    module_map_update();
+}
+
+/* ── process targeting: act in steamwebhelper only ──────────────── */
+/*
+ * LD_PRELOAD reaches everything Steam starts, games included, and their
+ * own crash handlers, anti-cheat and hot syscall() loops are none of our
+ * business. Only programs named in STEAMFIX_TARGETS (or the policy's
+ * `targets`; by file name, "*" for all) get the handlers. Anywhere else
+ * the constructor installs nothing and the overrides pass straight
+ * through: sigaction()/signal() take the branch they take before the
+ * handlers are locked in, and syscall() compares against numbers that
+ * match no syscall.
+ */
+#define DEFAULT_TARGETS "steamwebhelper"
+
+static int disarmed = 0;
+
+/* The numbers syscall() diverts to steamfix_syscall_slow() */
+__attribute__((visibility("hidden"), used))
+long steamfix_syscall_trap[2] = { SYS_clone3, SYS_clone };
+
+static int process_targeted(void) {
+    const char *list = getenv("STEAMFIX_TARGETS");
+    if (!list)
+        list = policy_targets();
+    if (!list)
+        list = DEFAULT_TARGETS;
+
+    size_t len;
+    const char *exe = elf_basename(module_exe, &len);
+    for (const char *p = list; *p; ) {
+        p += strspn(p, " \t:,");
+        size_t n = strcspn(p, " \t:,");
+        if (n && ((n == 1 && *p == '*') || (n == len && memcmp(p, exe, n) == 0)))
+            return 1;
+        p += n;
+    }
+    return 0;
+}
+
+static void disarm(void) {
+    disarmed = 1;
+    steamfix_syscall_trap[0] = steamfix_syscall_trap[1] = -1;
+}
+
+#ifndef STEAMFIX_MINIMAL
+/* Pick up objects loaded since, once init() has built the map */
+static void module_map_refresh(void) {
+    if (!disarmed && __atomic_load_n(&module_map, __ATOMIC_ACQUIRE))
+        module_map_update();
+}
+
+typedef void *(*real_dlopen_t)(const char *, int);
+typedef int   (*real_dlclose_t)(void *);
+static real_dlopen_t  real_dlopen_fn  = NULL;
+static real_dlclose_t real_dlclose_fn = NULL;
+
+static void *va_stub_dlopen(const char *file, int mode);
+
+/*
+ * dlopen() resolves a bare name against its *caller's* DT_RUNPATH and
+ * $ORIGIN, in the caller's namespace, which glibc finds via the return
+ * address. So like dlsym() below the entry is assembly that tail-jumps
+ * into libc with that address untouched; only the libva stub is decided
+ * beforehand, in C. Objects it loads are picked up by the next dlopen(),
+ * dlclose() or dlsym() on a handle; until then the handlers attribute
+ * faults in them from /proc/self/maps.
+ */
+__attribute__((visibility("hidden"), used))
+real_dlopen_t steamfix_real_dlopen = NULL;
+
+__attribute__((visibility("hidden"), used))
+void *steamfix_dlopen_pre(const char *file, int mode) {
+    __atomic_store_n(&steamfix_real_dlopen, NEXT(real_dlopen_fn, "dlopen"), __ATOMIC_RELEASE);
+    if (disarmed)
+        return NULL;
+    module_map_refresh();
+    return va_stub_dlopen(file, mode);
+}
+
+/* void *dlopen(const char *file, int mode) */
+__asm__(
+    ".text\n"
+    ".globl dlopen\n"
+    ".type  dlopen, @function\n"
+    "dlopen:\n"
+    "    pushq %rdi\n"
+    "    pushq %rsi\n"
+    "    subq  $8, %rsp\n"
+    "    call  steamfix_dlopen_pre\n"
+    "    addq  $8, %rsp\n"
+    "    popq  %rsi\n"
+    "    popq  %rdi\n"
+    "    testq %rax, %rax\n"
+    "    jnz   1f\n"                        /* the libva stub           */
+    "    movq  steamfix_real_dlopen(%rip), %rax\n"
+    "    testq %rax, %rax\n"
+    "    jz    1f\n"
+    "    jmp   *%rax\n"
+    "1:  ret\n"
+    ".size  dlopen, .-dlopen\n"
+);
+
+STEAMFIX_EXPORT
+int dlclose(void *handle) {
+    real_dlclose_t real = NEXT(real_dlclose_fn, "dlclose");
+    int ret = real(handle);
+    if (ret == 0 && !disarmed)
+        module_map_update();
+    return ret;
+}
+#endif
+
+/* ── crash-site allowlist ──────────────────────────────────────────── */
+/*
+ * Only sites listed in crash_sites.txt (compiled into crash_sites.h) are
+ * recovered; a NULL fault anywhere else is a real bug and crashes, rather
+ * than carrying on with corrupted state. Sites are attributed through the
+ * module map; code it doesn't cover (dlmopen(), a fault before init())
+ * falls back to scanning /proc/self/maps with raw syscalls and reading
+ * the ELF headers in place. A site neither can attribute is refused
+ * unless STEAMFIX_SITES=unattributed. Verdicts are cached per site.
+ */
+#define SITE_CACHE_SLOTS    64
+#define SITE_LINE_MAX       512
+
+/* STEAMFIX_SITES=any: recover anywhere, as before the allowlist */
+static int sites_anywhere = 0;
+/* STEAMFIX_SITES=unattributed: also where no module can be named */
+static int sites_unattributed = 0;
+
+/* site << 16 | profile slot + 1 << 5 | kind << 1 | allowed; 0 = empty */
+static uint64_t site_cache[SITE_CACHE_SLOTS];
+
+static void site_cache_flush(void) {
+    for (unsigned i = 0; i < SITE_CACHE_SLOTS; i++)
+        __atomic_store_n(&site_cache[i], 0, __ATOMIC_RELAXED);
+}
+
+struct site_maps {
+    uint64_t addr;
+    int      found;             /* the current run contains addr         */
+    uint64_t base;              /* its offset-0 mapping                  */
+    char     path[256];
+    struct elf_ranges readable; /* readable mappings of the run          */
+};
+
+static uint64_t site_hex(const char **s) {
+    uint64_t v = 0;
+    for (;; (*s)++) {
+        char c = **s;
+        if (c >= '0' && c <= '9')      v = v << 4 | (uint64_t)(c - '0');
+        else if (c >= 'a' && c <= 'f') v = v << 4 | (uint64_t)(c - 'a' + 10);
+        else return v;
+    }
+}
+
+/* One line of /proc/self/maps; returns 1 once addr's run is complete */
+static int site_maps_line(struct site_maps *m, const char *line) {
+    const char *s = line;
+    uint64_t lo = site_hex(&s);
+    if (*s++ != '-')
+        return 0;
+    uint64_t hi = site_hex(&s);
+    const char *perms = ++s;
+    s += 5;
+    uint64_t off = site_hex(&s);
+    /* dev and inode, then the path (if any) */
+    for (int field = 0; field < 3 && *s; ) {
+        while (*s == ' ')
+            s++;
+        if (field++ < 2)
+            while (*s && *s != ' ')
+                s++;
+    }
+
+    if (strcmp(s, m->path) != 0 || !*s) {
+        if (m->found)
+            return 1;
+        size_t n = strlen(s);
+        if (n >= sizeof(m->path))
+            n = sizeof(m->path) - 1;
+        memcpy(m->path, s, n);
+        m->path[n] = 0;
+        m->base = 0;
+        m->readable.n = 0;
+    }
+    if (off == 0 && !m->found) {
+        /* A new instance of the same file starts here */
+        m->base = lo;
+        m->readable.n = 0;
+    }
+    if (perms[0] == 'r' && m->readable.n < ELF_RANGES) {
+        m->readable.r[m->readable.n].lo = lo;
+        m->readable.r[m->readable.n].hi = hi;
+        m->readable.n++;
+    }
+    if (m->addr >= lo && m->addr < hi && m->path[0] && m->base)
+        m->found = 1;
+    return 0;
+}
+
+static int site_scan_maps(struct site_maps *m) {
+    long fd = raw_syscall3(SYS_open, (long)"/proc/self/maps", O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0)
+        return 0;
+
+    char buf[2048], line[SITE_LINE_MAX];
+    size_t len = 0;
+    int done = 0;
+    long n;
+    while (!done && (n = raw_syscall3(SYS_read, fd, (long)buf, sizeof(buf))) > 0) {
+        for (long i = 0; i < n && !done; i++) {
+            if (buf[i] != '\n') {
+                if (len < sizeof(line) - 1)
+                    line[len++] = buf[i];
+                continue;
+            }
+            line[len] = 0;
+            len = 0;
+            done = site_maps_line(m, line);
+        }
+    }
+    raw_syscall3(SYS_close, fd, 0, 0);
+    return m->found;
+}
+
+/* Slow path: attribute `addr` from /proc/self/maps; 0 if it can't be */
+static int site_module_from_maps(uint64_t addr, struct module_range *mod) {
+    struct site_maps m;
+    memset(&m, 0, sizeof(m));
+    m.addr = addr;
+    if (!site_scan_maps(&m))
+        return 0;
+
+    size_t len;
+    const char *name = elf_basename(m.path, &len);
+    mod->name = steamfix_fnv1a(STEAMFIX_FNV_BASIS, name, len);
+    mod->bias = m.base;
+    mod->build_id = 0;
+    mod->eh_hdr = mod->eh_table = mod->eh_count = 0;
+    mod->dynamic = 0;
+
+    const Elf64_Ehdr *eh = (const Elf64_Ehdr *)m.base;
+    if (!elf_readable(&m.readable, m.base, sizeof(*eh)) ||
+        memcmp(eh->e_ident, ELFMAG, SELFMAG) != 0 ||
+        eh->e_ident[EI_CLASS] != ELFCLASS64 ||
+        eh->e_phentsize != sizeof(Elf64_Phdr))
+        return 1;
+    const Elf64_Phdr *ph = (const Elf64_Phdr *)(m.base + eh->e_phoff);
+    if (!elf_readable(&m.readable, (uint64_t)ph, (uint64_t)eh->e_phnum * sizeof(*ph)))
+        return 1;
+
+    uint64_t first = UINT64_MAX;
+    for (unsigned i = 0; i < eh->e_phnum; i++)
+        if (ph[i].p_type == PT_LOAD && ph[i].p_vaddr < first)
+            first = ph[i].p_vaddr;
+    if (first == UINT64_MAX)
+        return 1;
+    mod->bias = m.base - (first & ~(uint64_t)0xfff);
+    elf_identify(mod->bias, ph, eh->e_phnum, &m.readable, mod);
+    return 1;
+}
+
+static int site_in(const struct steamfix_site *table, uint64_t seed, unsigned bits,
+                   uint64_t module, uint64_t offset, uint32_t kind) {
+    const struct steamfix_site *s = &table[steamfix_site_slot(module, offset, seed, bits)];
+    return s->module == module && s->offset == offset && (s->kinds & kind);
+}
+
+/* In crash_sites.h, or among the policy's extra sites */
+static int site_listed(uint64_t module, uint64_t offset, uint32_t kind) {
+    if (site_in(steamfix_sites, STEAMFIX_SITES_SEED, STEAMFIX_SITES_BITS,
+                module, offset, kind))
+        return 1;
+    return policy && policy->sites_bits &&
+           site_in((const struct steamfix_site *)((const char *)policy + policy->sites_off),
+                   policy->sites_seed, policy->sites_bits, module, offset, kind);
+}
+
+/*
+ * May the handlers recover a fault of `kind` (STEAMFIX_SITE_*) at `site`?
+ * `*prof` is set to the site's profile entry, if it has one.
+ */
+static int site_allowed(uint64_t site, uint32_t kind, struct profile_site **prof) {
+    uint64_t key = site << 16 | (uint64_t)kind << 1;
+    uint64_t *slot = &site_cache[(site * 0x9E3779B97F4A7C15ull) >> 58];
+    uint64_t cached = __atomic_load_n(slot, __ATOMIC_RELAXED);
+    struct profile *p = __atomic_load_n(&profile, __ATOMIC_ACQUIRE);
+    if ((cached & ~0xffe1ull) == key) {
+        uint64_t index = (cached >> 5) & 0x7ff;
+        *prof = index && p ? &p->site[index - 1] : NULL;
+        return (int)(cached & 1);
+    }
+
+    struct module_range mod;
+    int allowed;
+    *prof = NULL;
+    if (!module_lookup(site, &mod) && !site_module_from_maps(site, &mod)) {
+        /* Unattributable (JIT code, no /proc?): only if asked to */
+        allowed = sites_anywhere || sites_unattributed;
+    } else {
+        uint64_t offset = site - mod.bias;
+        allowed = sites_anywhere ||
+                  (mod.build_id &&
+                   (site_listed(mod.build_id, offset, kind) ||
+                    site_listed(mod.build_id, STEAMFIX_SITE_ANYWHERE, kind))) ||
+                  site_listed(mod.name, offset, kind) ||
+                  site_listed(mod.name, STEAMFIX_SITE_ANYWHERE, kind);
+        uint64_t sym;
+        if (!allowed && (sym = module_symbol(&mod, site)))
+            allowed = (mod.build_id && site_listed(mod.build_id, sym, kind)) ||
+                      site_listed(mod.name, sym, kind);
+        if (allowed)
+            *prof = profile_site(mod.build_id ? mod.build_id : mod.name, offset, kind);
+    }
+    uint64_t index = *prof ? (uint64_t)(*prof - p->site) + 1 : 0;
+    __atomic_store_n(slot, key | index << 5 | (uint64_t)allowed, __ATOMIC_RELAXED);
+    return allowed;
+}
+
+/* ── CFI unwinder: exact frame skipping from .eh_frame ───────────────── */
+/*
+ * Walking rbp only works through code built with frame pointers; in
+ * anything built with -fomit-frame-pointer it resumes in garbage. The
+ * compiler's unwind tables don't have that problem, so the handlers
+ * unwind with them: the module map keeps every object's .eh_frame_hdr
+ * search table (already sorted by pc), a fault costs two binary searches
+ * and a run of the FDE's CFA program up to the pc — reads of read-only
+ * data, a bounded number of them, no allocation and no loader calls.
+ * Callee-saved registers are restored from the frames we skip.
+ *
+ * Only what compilers emit for x86-64 is understood; DWARF expressions,
+ * register-in-register rules and the like make the unwind fail, and the
+ * caller falls back to the rbp chain.
+ */
+#define CFI_REGS        17          /* DWARF: 0-15 GPRs, 16 return address */
+#define CFI_RA          16
+#define CFI_MAX_OPS     512
+#define CFI_STATES      4           /* DW_CFA_remember_state depth       */
+#define CFI_FRAME_MAX   (1u << 20)  /* sanity bound on one frame's size  */
+
+enum { CFI_SAME = 0, CFI_UNDEFINED, CFI_OFFSET, CFI_VAL_OFFSET };
+
+struct cfi_row {
+    uint64_t cfa_reg;
+    int64_t  cfa_off;
+    uint8_t  rule[CFI_REGS];
+    int64_t  off[CFI_REGS];
+};
+
+struct cfi_cie {
+    uint64_t code_align;
+    int64_t  data_align;
+    uint64_t ra_reg;
+    uint8_t  fde_enc;
+    int      has_aug;               /* 'z': FDEs carry augmentation data */
+    const uint8_t *insns, *end;
+};
+
+/* DWARF register number → gregs index */
+static const int cfi_greg[16] = {
+    REG_RAX, REG_RDX, REG_RCX, REG_RBX, REG_RSI, REG_RDI, REG_RBP, REG_RSP,
+    REG_R8, REG_R9, REG_R10, REG_R11, REG_R12, REG_R13, REG_R14, REG_R15,
+};
+
+static int cfi_uleb(const uint8_t **p, const uint8_t *end, uint64_t *out) {
+    uint64_t v = 0;
+    for (unsigned shift = 0; *p < end && shift < 64; shift += 7) {
+        uint8_t b = *(*p)++;
+        v |= (uint64_t)(b & 0x7f) << shift;
+        if (!(b & 0x80)) {
+            *out = v;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int cfi_sleb(const uint8_t **p, const uint8_t *end, int64_t *out) {
+    uint64_t v = 0;
+    unsigned shift = 0;
+    uint8_t b = 0x80;
+    while (*p < end && shift < 64 && (b & 0x80)) {
+        b = *(*p)++;
+        v |= (uint64_t)(b & 0x7f) << shift;
+        shift += 7;
+    }
+    if (b & 0x80)
+        return 0;
+    if (shift < 64 && (b & 0x40))
+        v |= ~(uint64_t)0 << shift;
+    *out = (int64_t)v;
+    return 1;
+}
+
+/* A DW_EH_PE_* encoded pointer; absptr/pcrel/datarel, no indirection */
+static int cfi_pointer(const uint8_t **p, const uint8_t *end, uint8_t enc,
+                       uint64_t datarel, uint64_t *out) {
+    const uint8_t *start = *p;
+    uint64_t v;
+    size_t n;
+    if (enc == 0xff)                /* DW_EH_PE_omit */
+        return 0;
+    switch (enc & 0x0f) {
+    case 0x00: n = 8; break;                                /* absptr */
+    case 0x02: case 0x0a: n = 2; break;                     /* (s)data2 */
+    case 0x03: case 0x0b: n = 4; break;                     /* (s)data4 */
+    case 0x04: case 0x0c: n = 8; break;                     /* (s)data8 */
+    case 0x01: if (!cfi_uleb(p, end, &v)) return 0; n = 0; break;
+    case 0x09: if (!cfi_sleb(p, end, (int64_t *)&v)) return 0; n = 0; break;
+    default:   return 0;
+    }
+    if (n) {
+        if ((size_t)(end - *p) < n)
+            return 0;
+        switch (enc & 0x0f) {
+        case 0x02: { uint16_t x; memcpy(&x, *p, 2); v = x; break; }
+        case 0x0a: { int16_t  x; memcpy(&x, *p, 2); v = (uint64_t)(int64_t)x; break; }
+        case 0x03: { uint32_t x; memcpy(&x, *p, 4); v = x; break; }
+        case 0x0b: { int32_t  x; memcpy(&x, *p, 4); v = (uint64_t)(int64_t)x; break; }
+        default:   memcpy(&v, *p, 8); break;
+        }
+        *p += n;
+    }
+    switch (enc & 0x70) {
+    case 0x00: break;
+    case 0x10: v += (uint64_t)start; break;                 /* pcrel   */
+    case 0x30: v += datarel; break;                         /* datarel */
+    default:   return 0;
+    }
+    if (enc & 0x80)                 /* DW_EH_PE_indirect */
+        return 0;
+    *out = v;
+    return 1;
+}
+
+/* Length-prefixed .eh_frame entry at p: its body, or NULL */
+static const uint8_t *cfi_entry(const uint8_t *p, const uint8_t **end) {
+    uint32_t len;
+    memcpy(&len, p, 4);
+    if (len == 0 || len == 0xffffffffu)     /* terminator, 64-bit DWARF */
+        return NULL;
+    *end = p + 4 + len;
+    return p + 4;
+}
+
+static int cfi_parse_cie(const uint8_t *cie, struct cfi_cie *out) {
+    const uint8_t *end, *p = cfi_entry(cie, &end);
+    uint32_t id;
+    if (!p)
+        return 0;
+    memcpy(&id, p, 4);
+    p += 4;
+    if (id != 0 || p >= end)
+        return 0;
+    uint8_t version = *p++;
+    const char *aug = (const char *)p;
+    while (p < end && *p)
+        p++;
+    if (p++ >= end)
+        return 0;
+    if (aug[0] && aug[0] != 'z')
+        return 0;
+    if (!cfi_uleb(&p, end, &out->code_align) || !cfi_sleb(&p, end, &out->data_align))
+        return 0;
+    if (version == 1) {
+        if (p >= end)
+            return 0;
+        out->ra_reg = *p++;
+    } else if (!cfi_uleb(&p, end, &out->ra_reg)) {
+        return 0;
+    }
+
+    out->fde_enc = 0;
+    out->has_aug = aug[0] == 'z';
+    if (out->has_aug) {
+        uint64_t len;
+        if (!cfi_uleb(&p, end, &len) || len > (uint64_t)(end - p))
+            return 0;
+        const uint8_t *data = p, *data_end = p + len;
+        for (const char *a = aug + 1; *a; a++) {
+            uint64_t ignored;
+            switch (*a) {
+            case 'R':
+                if (data >= data_end) return 0;
+                out->fde_enc = *data++;
+                break;
+            case 'L':
+                if (data >= data_end) return 0;
+                data++;
+                break;
+            case 'P': {
+                if (data >= data_end) return 0;
+                uint8_t enc = *data++;
+                /* The personality routine may be indirect; skip it by size */
+                if (!cfi_pointer(&data, data_end, enc & 0x0f, 0, &ignored))
+                    return 0;
+                break;
+            }
+            case 'S': case 'B':
+                break;
+            default:
+                return 0;
+            }
+        }
+        p = data_end;
+    }
+    if (out->ra_reg != CFI_RA)
+        return 0;
+    out->insns = p;
+    out->end = end;
+    return 1;
+}
+
+/* Run CFA instructions until the location passes `pc` */
+static int cfi_run(const uint8_t *p, const uint8_t *end, const struct cfi_cie *cie,
+                   uint64_t loc, uint64_t pc, struct cfi_row *row,
+                   const struct cfi_row *initial) {
+    struct cfi_row saved[CFI_STATES];
+    unsigned depth = 0;
+
+    for (unsigned ops = 0; p < end && ops < CFI_MAX_OPS; ops++) {
+        uint8_t op = *p++;
+        uint64_t reg, u, delta = 0;
+        int64_t s;
+
+        switch (op & 0xc0) {
+        case 0x40:                                  /* advance_loc */
+            delta = (op & 0x3f) * cie->code_align;
+            goto advance;
+        case 0x80:                                  /* offset */
+            reg = op & 0x3f;
+            if (!cfi_uleb(&p, end, &u))
+                return 0;
+            s = (int64_t)u * cie->data_align;
+            goto set_offset;
+        case 0xc0:                                  /* restore */
+            reg = op & 0x3f;
+            goto restore;
+        }
+
+        switch (op) {
+        case 0x00:                                  /* nop */
+            continue;
+        case 0x01:                                  /* set_loc */
+            if (!cfi_pointer(&p, end, cie->fde_enc, 0, &u))
+                return 0;
+            if (u > pc)
+                return 1;
+            loc = u;
+            continue;
+        case 0x02:                                  /* advance_loc1 */
+            if (p + 1 > end) return 0;
+            delta = *p * cie->code_align;
+            p += 1;
+            goto advance;
+        case 0x03: {                                /* advance_loc2 */
+            uint16_t x;
+            if (p + 2 > end) return 0;
+            memcpy(&x, p, 2);
+            p += 2;
+            delta = x * cie->code_align;
+            goto advance;
+        }
+        case 0x04: {                                /* advance_loc4 */
+            uint32_t x;
+            if (p + 4 > end) return 0;
+            memcpy(&x, p, 4);
+            p += 4;
+            delta = x * cie->code_align;
+            goto advance;
+        }
+        case 0x05:                                  /* offset_extended */
+            if (!cfi_uleb(&p, end, &reg) || !cfi_uleb(&p, end, &u))
+                return 0;
+            s = (int64_t)u * cie->data_align;
+            goto set_offset;
+        case 0x06:                                  /* restore_extended */
+            if (!cfi_uleb(&p, end, &reg))
+                return 0;
+            goto restore;
+        case 0x07:                                  /* undefined */
+        case 0x08:                                  /* same_value */
+            if (!cfi_uleb(&p, end, &reg))
+                return 0;
+            if (reg < CFI_REGS)
+                row->rule[reg] = op == 0x07 ? CFI_UNDEFINED : CFI_SAME;
+            continue;
+        case 0x0a:                                  /* remember_state */
+            if (depth == CFI_STATES)
+                return 0;
+            saved[depth++] = *row;
+            continue;
+        case 0x0b:                                  /* restore_state */
+            if (depth == 0)
+                return 0;
+            *row = saved[--depth];
+            continue;
+        case 0x0c:                                  /* def_cfa */
+            if (!cfi_uleb(&p, end, &row->cfa_reg) || !cfi_uleb(&p, end, &u))
+                return 0;
+            row->cfa_off = (int64_t)u;
+            continue;
+        case 0x0d:                                  /* def_cfa_register */
+            if (!cfi_uleb(&p, end, &row->cfa_reg))
+                return 0;
+            continue;
+        case 0x0e:                                  /* def_cfa_offset */
+            if (!cfi_uleb(&p, end, &u))
+                return 0;
+            row->cfa_off = (int64_t)u;
+            continue;
+        case 0x11:                                  /* offset_extended_sf */
+            if (!cfi_uleb(&p, end, &reg) || !cfi_sleb(&p, end, &s))
+                return 0;
+            s *= cie->data_align;
+            goto set_offset;
+        case 0x12:                                  /* def_cfa_sf */
+            if (!cfi_uleb(&p, end, &row->cfa_reg) || !cfi_sleb(&p, end, &s))
+                return 0;
+            row->cfa_off = s * cie->data_align;
+            continue;
+        case 0x13:                                  /* def_cfa_offset_sf */
+            if (!cfi_sleb(&p, end, &s))
+                return 0;
+            row->cfa_off = s * cie->data_align;
+            continue;
+        case 0x14:                                  /* val_offset */
+            if (!cfi_uleb(&p, end, &reg) || !cfi_uleb(&p, end, &u))
+                return 0;
+            if (reg < CFI_REGS) {
+                row->rule[reg] = CFI_VAL_OFFSET;
+                row->off[reg] = (int64_t)u * cie->data_align;
+            }
+            continue;
+        case 0x2e:                                  /* GNU_args_size */
+            if (!cfi_uleb(&p, end, &u))
+                return 0;
+            continue;
+        default:
+            /* def_cfa_expression, expression, register, ...: give up */
+            return 0;
+        }
+
+    advance:
+        if (loc + delta > pc)
+            return 1;
+        loc += delta;
+        continue;
+    set_offset:
+        if (reg < CFI_REGS) {
+            row->rule[reg] = CFI_OFFSET;
+            row->off[reg] = s;
+        }
+        continue;
+    restore:
+        if (reg < CFI_REGS && initial) {
+            row->rule[reg] = initial->rule[reg];
+            row->off[reg] = initial->off[reg];
+        }
+        continue;
+    }
+    return p >= end;
+}
+
+/* The FDE covering `pc` in `mod`, or NULL */
+static const uint8_t *cfi_find_fde(const struct module_range *mod, uint64_t pc) {
+    const int32_t *table = (const int32_t *)mod->eh_table;
+    size_t lo = 0, hi = mod->eh_count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (mod->eh_hdr + (int64_t)table[2 * mid] <= pc)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (!lo)
+        return NULL;
+    return (const uint8_t *)(mod->eh_hdr + (int64_t)table[2 * (lo - 1) + 1]);
+}
+
+/* Unwind one frame of `regs` (gregs layout) at `pc`; `regs` is updated */
+static int cfi_step(uint64_t *regs, uint64_t pc) {
+    struct module_range mod;
+    if (!module_lookup(pc, &mod) || !mod.eh_count)
+        return 0;
+    const uint8_t *fde = cfi_find_fde(&mod, pc);
+    if (!fde)
+        return 0;
+
+    const uint8_t *end, *p = cfi_entry(fde, &end);
+    uint32_t cie_off;
+    if (!p)
+        return 0;
+    memcpy(&cie_off, p, 4);
+    if (cie_off == 0)
+        return 0;
+    struct cfi_cie cie;
+    if (!cfi_parse_cie(p - cie_off, &cie))
+        return 0;
+    p += 4;
+
+    uint64_t begin, range;
+    if (!cfi_pointer(&p, end, cie.fde_enc, 0, &begin) ||
+        !cfi_pointer(&p, end, cie.fde_enc & 0x0f, 0, &range) ||
+        pc < begin || pc - begin >= range)
+        return 0;
+    if (cie.has_aug) {
+        uint64_t len;
+        if (!cfi_uleb(&p, end, &len) || len > (uint64_t)(end - p))
+            return 0;
+        p += len;
+    }
+
+    struct cfi_row row, initial;
+    memset(&row, 0, sizeof(row));
+    if (!cfi_run(cie.insns, cie.end, &cie, begin, UINT64_MAX, &row, NULL))
+        return 0;
+    initial = row;
+    if (!cfi_run(p, end, &cie, begin, pc, &row, &initial))
+        return 0;
+
+    if ((row.cfa_reg != 7 && row.cfa_reg != 6) || row.rule[CFI_RA] != CFI_OFFSET)
+        return 0;
+    uint64_t sp = regs[REG_RSP];
+    uint64_t cfa = regs[cfi_greg[row.cfa_reg]] + (uint64_t)row.cfa_off;
+    /* The caller's frame lies above ours, and not absurdly far */
+    if (cfa <= sp || cfa - sp > CFI_FRAME_MAX)
+        return 0;
+
+    uint64_t next[CFI_REGS] = { 0 };
+    for (int r = 0; r < 16; r++)
+        next[r] = regs[cfi_greg[r]];
+    for (int r = 0; r < CFI_REGS; r++) {
+        uint64_t slot = cfa + (uint64_t)row.off[r];
+        switch (row.rule[r]) {
+        case CFI_OFFSET:
+            if (slot < sp || slot + 8 > cfa + CFI_FRAME_MAX)
+                return 0;
+            next[r] = *(const uint64_t *)slot;
+            break;
+        case CFI_VAL_OFFSET:
+            next[r] = slot;
+            break;
+        }
+    }
+    for (int r = 0; r < 16; r++)
+        regs[cfi_greg[r]] = next[r];
+    regs[REG_RSP] = cfa;
+    regs[REG_RIP] = next[CFI_RA];
+    return 1;
+}
+
+/*
+ * Return 0 out of `frames` frames using unwind tables, or leave `ctx`
+ * alone and return 0. `at_return` says the first pc is a return address
+ * (or just past a trap) rather than the faulting instruction itself.
+ */
+static int return_via_cfi(ucontext_t *ctx, int frames, int at_return) {
+    uint64_t regs[NGREG];
+    for (int i = 0; i < NGREG; i++)
+        regs[i] = (uint64_t)ctx->uc_mcontext.gregs[i];
+
+    for (int i = 0; i < frames; i++) {
+        uint64_t pc = regs[REG_RIP] - (uint64_t)(i > 0 || at_return);
+        if (!cfi_step(regs, pc))
+            return 0;
+    }
+    for (int i = 0; i < NGREG; i++)
+        ctx->uc_mcontext.gregs[i] = (greg_t)regs[i];
+    ctx->uc_mcontext.gregs[REG_RAX] = 0;
+    return 1;
+}
+
+/* ── alternate signal stacks: one arena, a slot per thread ─────────── */
+/*
+ * Without an alternate stack the handlers run on the faulting thread's
+ * own, which fails when that is almost exhausted. Chromium starts dozens
+ * of threads per process, so instead of an mmap() per thread the stacks
+ * are slots in one arena reserved in init(), separated by guard pages
+ * (guard regions where the kernel supports them, which don't split the
+ * mapping) put in place as slots are first handed out. Threads from
+ * pthread_create() get a slot before running; any other thread gets one
+ * on its first fault, for the next one.
+ *
+ * A slot is owned by a tid. Slots aren't released on thread exit —
+ * nothing runs reliably there — but reclaimed once their owner is gone.
+ */
+#define ALTSTACK_SLOTS  256
+#define ALTSTACK_SIZE   (64u << 10)
+#define ALTSTACK_GUARD  4096u
+
+#ifndef MADV_GUARD_INSTALL
+#define MADV_GUARD_INSTALL 102
+#endif
+
+#define ALTSTACK_PENDING UINT32_MAX   /* claimed for a thread not yet running */
+
+static uint8_t *altstack_arena = NULL;
+static uint32_t altstack_owner[ALTSTACK_SLOTS];    /* tid, 0 = free */
+static uint8_t altstack_guarded[ALTSTACK_SLOTS + 1];
+static uint32_t altstack_pid = 0;
+
+static __thread int altstack_slot __attribute__((tls_model("initial-exec"))) = -1;
+
+static uint8_t *altstack_base(int slot) {
+    return altstack_arena + ALTSTACK_GUARD + (size_t)slot * (ALTSTACK_SIZE + ALTSTACK_GUARD);
+}
+
+/*
+ * A free slot for `tid`, else one whose thread has exited. Both searches
+ * start where the last claim ended and read before they CAS, so a full
+ * arena of dead owners costs one tgkill(), not a locked op per slot.
+ */
+static int altstack_claim(uint32_t tid) {
+    static unsigned next;
+    unsigned from = __atomic_load_n(&next, __ATOMIC_RELAXED);
+    for (unsigned n = 0; n < ALTSTACK_SLOTS; n++) {
+        unsigned i = (from + n) % ALTSTACK_SLOTS;
+        uint32_t none = 0;
+        if (__atomic_load_n(&altstack_owner[i], __ATOMIC_RELAXED) == 0 &&
+            __atomic_compare_exchange_n(&altstack_owner[i], &none, tid, 0,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            __atomic_store_n(&next, i + 1, __ATOMIC_RELAXED);
+            return (int)i;
+        }
+    }
+    uint32_t pid = __atomic_load_n(&altstack_pid, __ATOMIC_RELAXED);
+    for (unsigned n = 0; n < ALTSTACK_SLOTS; n++) {
+        unsigned i = (from + n) % ALTSTACK_SLOTS;
+        uint32_t owner = __atomic_load_n(&altstack_owner[i], __ATOMIC_RELAXED);
+        if (owner != ALTSTACK_PENDING &&
+            raw_syscall3(SYS_tgkill, pid, owner, 0) == -ESRCH &&
+            __atomic_compare_exchange_n(&altstack_owner[i], &owner, tid, 0,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            __atomic_store_n(&next, i + 1, __ATOMIC_RELAXED);
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+/* Guard pages below and above `slot`, once; a neighbour may have done either */
+static int altstack_guard(int slot) {
+    for (int i = slot; i <= slot + 1; i++) {
+        if (__atomic_load_n(&altstack_guarded[i], __ATOMIC_ACQUIRE))
+            continue;
+        long guard = (long)(altstack_arena + (size_t)i * (ALTSTACK_SIZE + ALTSTACK_GUARD));
+        if (raw_syscall3(SYS_madvise, guard, ALTSTACK_GUARD, MADV_GUARD_INSTALL) != 0 &&
+            raw_syscall3(SYS_mprotect, guard, ALTSTACK_GUARD, PROT_NONE) != 0)
+            return 0;
+        __atomic_store_n(&altstack_guarded[i], 1, __ATOMIC_RELEASE);
+    }
+    return 1;
+}
+
+/* Make claimed `slot` the calling thread's alternate stack */
+static void altstack_use(int slot) {
+    if (!altstack_guard(slot)) {
+        __atomic_store_n(&altstack_owner[slot], 0, __ATOMIC_RELEASE);
+        return;
+    }
+    stack_t ss = { .ss_sp = altstack_base(slot), .ss_size = ALTSTACK_SIZE };
+    if (raw_syscall3(SYS_sigaltstack, (long)&ss, 0, 0) != 0) {
+        __atomic_store_n(&altstack_owner[slot], 0, __ATOMIC_RELEASE);
+        return;
+    }
+    altstack_slot = slot;
+}
+
+/* Give the calling thread an alternate stack; async-signal-safe */
+static void altstack_install(void) {
+    if (!altstack_arena || altstack_slot >= 0)
+        return;
+    int slot = altstack_claim((uint32_t)raw_syscall0(SYS_gettid));
+    if (slot >= 0)
+        altstack_use(slot);
+}
+
+/* New pid and tid: the one surviving thread keeps its slot, the rest are dead */
+static void altstack_after_fork(void) {
+    __atomic_store_n(&altstack_pid, (uint32_t)raw_syscall0(SYS_getpid), __ATOMIC_RELAXED);
+    if (altstack_slot >= 0)
+        __atomic_store_n(&altstack_owner[altstack_slot],
+                         (uint32_t)raw_syscall0(SYS_gettid), __ATOMIC_RELEASE);
+}
+
+static void altstack_init(void) {
+    size_t len = ALTSTACK_GUARD + (size_t)ALTSTACK_SLOTS * (ALTSTACK_SIZE + ALTSTACK_GUARD);
+    uint8_t *arena = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+    if (arena == MAP_FAILED)
+        return;
+    altstack_pid = (uint32_t)getpid();
+    altstack_arena = arena;
+    pthread_atfork(NULL, NULL, altstack_after_fork);
+    altstack_install();
+}
+
+#ifndef STEAMFIX_MINIMAL
+/* What pthread_create() was asked to run, per slot claimed for it */
+static struct altstack_start {
+    void *(*fn)(void *);
+    void *arg;
+} altstack_start[ALTSTACK_SLOTS];
+
+static void *altstack_thread(void *p) {
+    int slot = (int)(intptr_t)p;
+    struct altstack_start start = altstack_start[slot];
+    __atomic_store_n(&altstack_owner[slot], (uint32_t)raw_syscall0(SYS_gettid),
+                     __ATOMIC_RELEASE);
+    altstack_use(slot);
+    return start.fn(start.arg);
+}
+
+typedef int (*real_pthread_create_t)(pthread_t *, const pthread_attr_t *,
+                                     void *(*)(void *), void *);
+static real_pthread_create_t real_pthread_create_fn = NULL;
+
+STEAMFIX_EXPORT
+int pthread_create(pthread_t *thread, const pthread_attr_t *attr,
+                   void *(*fn)(void *), void *arg) {
+    real_pthread_create_t real = NEXT(real_pthread_create_fn, "pthread_create");
+    int slot = altstack_arena ? altstack_claim(ALTSTACK_PENDING) : -1;
+    if (slot < 0)
+        return real(thread, attr, fn, arg);
+    altstack_start[slot].fn = fn;
+    altstack_start[slot].arg = arg;
+    int ret = real(thread, attr, altstack_thread, (void *)(intptr_t)slot);
+    if (ret != 0)
+        __atomic_store_n(&altstack_owner[slot], 0, __ATOMIC_RELEASE);
+    return ret;
+}
+#endif
+
+/* ── recovery helpers ──────────────────────────────────────────────── */
+/* Return 0 to the address on top of the stack (undo a call) */
+static void return_via_rsp(ucontext_t *ctx, uint64_t rsp) {
+    ctx->uc_mcontext.gregs[REG_RAX] = 0;
+    ctx->uc_mcontext.gregs[REG_RIP] = *(uint64_t *)rsp;
+    ctx->uc_mcontext.gregs[REG_RSP] = rsp + 8;
+}
+
+/* Return 0 out of `frames` rbp-chained frames, starting at `rbp` */
+static int return_via_rbp(ucontext_t *ctx, uint64_t rbp, int frames) {
+    for (int i = 1; i < frames; i++) {
+        if (rbp <= 0x10000)
+            return 0;
+        rbp = ((uint64_t *)rbp)[0];
+    }
+    if (rbp <= 0x10000)
+        return 0;
+
+    uint64_t *frame = (uint64_t *)rbp;
+    ctx->uc_mcontext.gregs[REG_RAX] = 0;
+    ctx->uc_mcontext.gregs[REG_RBP] = frame[0];
+    ctx->uc_mcontext.gregs[REG_RIP] = frame[1];
+    ctx->uc_mcontext.gregs[REG_RSP] = rbp + 16;
+    return 1;
+}
+
+static const uint8_t stub_prologue[4] = { 0x55, 0x48, 0x89, 0xe5 };  /* push rbp; mov rbp,rsp */
+static const uint8_t hotpatch_code[4] = { 0x31, 0xc0, 0xc9, 0xc3 };  /* xor eax,eax; leave; ret */
+
+/*
+ * The outlined NOTREACHED stub `rip` trapped in, or NULL: the prologue,
+ * then int3 (rip past it) or ud2 (rip on it), all on rip's page. A stub
+ * hot-patched while this thread was already inside it counts too.
+ */
+static const uint8_t *trap_stub(uint64_t rip, int sig) {
+    const uint8_t *p = (const uint8_t *)rip;
+    uint64_t start = rip - (sig == SIGTRAP ? 5 : 4);
+    if ((start ^ rip) & ~(uint64_t)4095)
+        return NULL;
+    if (sig == SIGTRAP ? p[-1] != 0xcc : p[0] != 0x0f || p[1] != 0x0b)
+        return NULL;
+    return memcmp((const void *)start, stub_prologue, 4) == 0 ||
+           memcmp((const void *)start, hotpatch_code, 4) == 0 ? (const uint8_t *)start : NULL;
+}
+
+/* Return 0 out of `frames` frames: by unwind tables, else along rbp */
+static int return_via_frames(ucontext_t *ctx, int frames, int at_return) {
+    return return_via_cfi(ctx, frames, at_return) ||
+           return_via_rbp(ctx, ctx->uc_mcontext.gregs[REG_RBP], frames);
+}
+
+/* ── stub hot-patching (STEAMFIX_HOTPATCH=1) ───────────────────────── */
+/*
+ * A NOTREACHED stub that CEF hits over and over costs a signal delivery
+ * each time, for a recovery that never changes: return 0 out of the stub
+ * and its caller. When the caller keeps a frame pointer, that recovery
+ * is exactly what `xor eax,eax; leave; ret` does from the stub's first
+ * byte: the caller's frame is torn down and its caller resumed. Those
+ * are four bytes, as many as `push rbp; mov rbp,rsp`.
+ *
+ * So at an allowlisted stub, each recovery is also done by unwinding
+ * along rbp alone and compared with the one return_via_frames() picks.
+ * If the two agree on every register HOTPATCH_HITS times (no callee-saved
+ * register for the caller to restore), the prologue is rewritten once,
+ * with a single 32-bit store that doesn't cross a cache line, under a
+ * temporary PROT_WRITE. Later hits then cost four instructions. Stubs not
+ * in this form, and callers without frame pointers, keep the handler.
+ * Another caller of the same stub that wasn't seen may still need its
+ * registers back; that is why this is opt-in.
+ *
+ * Stubs on one page share its protection, so patches are serialised by
+ * a spinlock: otherwise one thread's PROT_READ|PROT_EXEC could land
+ * before another's store, which would then fault in the handler. Only
+ * the handler takes it, with no fault possible while it is held.
+ *
+ * A thread already inside the stub can't resume mid-instruction: the old
+ * instructions start at bytes 0, 1 and 4, the new ones at 0, 2, 3 and 4.
+ * Past `push rbp`, byte 1 now decodes as `ror $0xc3,%cl` (rcx is call-
+ * clobbered) and runs into the trap at byte 4, as one past `mov rbp,rsp`
+ * does, only without rbp set. hotpatch_resume() sets it, and trap_stub()
+ * takes the patched bytes for the prologue, so the recovery is as before.
+ */
+#define HOTPATCH_SLOTS  32
+#define HOTPATCH_PROBE  4
+#define HOTPATCH_HITS   3
+#define HOTPATCH_DONE   UINT32_MAX
+
+static int hotpatch_enabled = 0;
+static struct {
+    uint64_t stub;              /* stub's first byte, 0 = free           */
+    uint32_t hits;              /* agreeing recoveries, or HOTPATCH_DONE */
+} hotpatch_sites[HOTPATCH_SLOTS];
+
+/* The stub `rip` trapped in, if its prologue doesn't cross a cache line */
+static uint8_t *hotpatch_stub(uint64_t rip, int sig) {
+    uint8_t *start = (uint8_t *)trap_stub(rip, sig);
+    return start && ((uintptr_t)start & 63) <= 60 ? start : NULL;
+}
+
+static void hotpatch_apply(uint8_t *stub) {
+    static int lock;
+    uintptr_t page = (uintptr_t)stub & ~(uintptr_t)4095;
+    uint32_t code;
+    memcpy(&code, hotpatch_code, 4);
+    while (__atomic_exchange_n(&lock, 1, __ATOMIC_ACQUIRE))
+        __builtin_ia32_pause();
+    if (raw_syscall3(SYS_mprotect, (long)page, 4096, PROT_READ | PROT_WRITE | PROT_EXEC) == 0) {
+        __atomic_store_n((uint32_t *)stub, code, __ATOMIC_SEQ_CST);
+        raw_syscall3(SYS_mprotect, (long)page, 4096, PROT_READ | PROT_EXEC);
+        PROBE(hotpatch, 0, stub, 0, 0);
+    }
+    __atomic_store_n(&lock, 0, __ATOMIC_RELEASE);
+}
+
+/* A trap in a patched stub: whatever ran of the old prologue, rbp = rsp */
+static void hotpatch_resume(ucontext_t *ctx, const uint8_t *stub) {
+    if (stub && memcmp(stub, hotpatch_code, 4) == 0)
+        ctx->uc_mcontext.gregs[REG_RBP] = ctx->uc_mcontext.gregs[REG_RSP];
+}
+
+/* Count a recovery at `rip` the patch would reproduce; patch when due */
+static int hotpatch_observe(const ucontext_t *ctx, int sig, uint64_t rip) {
+    uint8_t *stub;
+    if (!hotpatch_enabled || !(stub = hotpatch_stub(rip, sig)))
+        return 0;
+
+    uint64_t key = (uintptr_t)stub;
+    for (unsigned i = 0; i < HOTPATCH_PROBE; i++) {
+        unsigned slot = (unsigned)(key + i) & (HOTPATCH_SLOTS - 1);
+        uint64_t k = __atomic_load_n(&hotpatch_sites[slot].stub, __ATOMIC_ACQUIRE);
+        if (k != key && (k != 0 ||
+            !__atomic_compare_exchange_n(&hotpatch_sites[slot].stub, &k, key, 0,
+                                         __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) && k != key)
+            continue;
+        uint32_t hits = __atomic_load_n(&hotpatch_sites[slot].hits, __ATOMIC_RELAXED);
+        if (hits == HOTPATCH_DONE)
+            return 0;
+
+        ucontext_t frames = *ctx, rbp = *ctx;
+        if (!return_via_frames(&frames, 2, sig == SIGTRAP) ||
+            !return_via_rbp(&rbp, rbp.uc_mcontext.gregs[REG_RBP], 2) ||
+            memcmp(frames.uc_mcontext.gregs, rbp.uc_mcontext.gregs, sizeof(gregset_t)) != 0)
+            return 0;
+        if (hits + 1 < HOTPATCH_HITS) {
+            __atomic_add_fetch(&hotpatch_sites[slot].hits, 1, __ATOMIC_RELAXED);
+            return 0;
+        }
+        /* One thread patches; the rest just recover */
+        if (!__atomic_compare_exchange_n(&hotpatch_sites[slot].hits, &hits, HOTPATCH_DONE, 0,
+                                         __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+            return 0;
+        hotpatch_apply(stub);
+        return 1;
+    }
+    return 0;
+}
+
+/* ── virtual dispositions: the handlers crashpad thinks it installed ─ */
+/*
+ * sigaction() and signal() don't let anyone replace our handlers for
+ * SIGSEGV/SIGTRAP/SIGILL, but they record what the caller asked for and
+ * report it back through oldact, and faults we don't recover are handed
+ * to it — so crashpad still writes a minidump for a genuine crash.
+ *
+ * Each signal's slot points at an immutable copy in a small ring; the
+ * handlers read it with one atomic load and no lock. A copy is only
+ * rewritten DISPOSITION_RING installs later, long after any reader.
+ */
+#define DISPOSITION_RING 32
+
+static struct sigaction disposition_ring[DISPOSITION_RING];
+static unsigned disposition_next = 0;
+static struct sigaction *disposition_slot[3];  /* SIGSEGV, SIGTRAP, SIGILL */
+
+static int disposition_index(int sig) {
+    switch (sig) {
+    case SIGSEGV: return 0;
+    case SIGTRAP: return 1;
+    case SIGILL:  return 2;
+    default:      return -1;
+    }
+}
+
+/* Record `act` for `sig`, copying the previous one to `oldact` */
+static void disposition_set(int sig, const struct sigaction *act, struct sigaction *oldact) {
+    struct sigaction **slot = &disposition_slot[disposition_index(sig)];
+    struct sigaction *old;
+    if (act) {
+        unsigned n = __atomic_fetch_add(&disposition_next, 1, __ATOMIC_RELAXED);
+        struct sigaction *copy = &disposition_ring[n % DISPOSITION_RING];
+        *copy = *act;
+        old = __atomic_exchange_n(slot, copy, __ATOMIC_ACQ_REL);
+    } else {
+        old = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+    }
+    if (oldact) {
+        if (old) {
+            *oldact = *old;
+        } else {
+            memset(oldact, 0, sizeof(*oldact));
+            oldact->sa_handler = SIG_DFL;
+        }
+    }
+}
+
+/* Genuine crash (or a storm we gave up on): restore default and re-raise */
+static void reraise_default(int sig, uint16_t kind, uint16_t path,
+                            uint64_t rip, uint64_t addr) {
+    struct sigaction sa = { .sa_handler = SIG_DFL };
+    PROBE(reraise, sig, rip, addr, path);
+    telemetry_record(kind, path, sig, rip, addr);
+    __atomic_store_n(&handlers_locked, 0, __ATOMIC_RELAXED);
+    sigaction(sig, &sa, NULL);
+    raise(sig);
+}
+
+/* A fault we won't recover: to the recorded handler if any, else SIG_DFL */
+static void pass_on(int sig, siginfo_t *info, void *ucontext, uint16_t kind,
+                    uint16_t path, uint64_t rip, uint64_t addr) {
+    storm_blame();
+    struct sigaction **slot = &disposition_slot[disposition_index(sig)];
+    const struct sigaction *h = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+    /* SIG_IGN can't ignore a fault: it would re-execute forever */
+    if (!h || h->sa_handler == SIG_DFL || h->sa_handler == SIG_IGN) {
+        reraise_default(sig, kind, path, rip, addr);
+        return;
+    }
+
+    PROBE(chained, sig, rip, addr, path);
+    telemetry_record(kind, path == STEAMFIX_PATH_RERAISE ? STEAMFIX_PATH_CHAINED : path,
+                     sig, rip, addr);
+    struct sigaction act = *h;
+    if (act.sa_flags & SA_RESETHAND) {
+        struct sigaction dfl = { .sa_handler = SIG_DFL };
+        disposition_set(sig, &dfl, NULL);
+    }
+    if (act.sa_flags & SA_SIGINFO)
+        act.sa_sigaction(sig, info, ucontext);
+    else
+        act.sa_handler(sig);
+}
+
+/* ── SIGSEGV: core fix ─────────────────────────────────────────────── */
+static void sigsegv_handler(int sig, siginfo_t *info, void *ucontext) {
+    ucontext_t *ctx = (ucontext_t *)ucontext;
+    uint64_t rip = ctx->uc_mcontext.gregs[REG_RIP];
+    uint64_t rsp = ctx->uc_mcontext.gregs[REG_RSP];
+    uint64_t addr = (uintptr_t)info->si_addr;
+
+    PROBE(sigsegv_entry, sig, rip, addr, 0);
+    altstack_install();
+
+    /* Case 1: jumped/called to NULL (rip near 0) — return 0 to caller */
+    if (rip < 0x10000) {
+        /* rip is ~0 for every such fault; the call site identifies it */
+        uint64_t site = *(uint64_t *)rsp;
+        struct profile_site *prof;
+        if (!site_allowed(site, STEAMFIX_SITE_CALL, &prof)) {
+            pass_on(sig, info, ucontext, STEAMFIX_EV_SIGSEGV, STEAMFIX_PATH_UNLISTED, site, addr);
+            return;
+        }
+        switch (storm_level(site, addr, prof)) {
+        case STORM_NORMAL:
+            return_via_rsp(ctx, rsp);
+            PROBE(sigsegv_return, sig, site, addr, 0);
+            telemetry_record(STEAMFIX_EV_SIGSEGV, STEAMFIX_PATH_RETURN, sig, site, addr);
+            return;
+        case STORM_ALTERNATE:
+            /* Caller keeps re-faulting: return from the caller as well.
+             * Unwound on a copy, so a failed unwind passes on the fault
+             * with the registers it happened with. */
+            ucontext_t up = *ctx;
+            return_via_rsp(&up, rsp);
+            if (return_via_frames(&up, 1, 1)) {
+                memcpy(ctx->uc_mcontext.gregs, up.uc_mcontext.gregs, sizeof(gregset_t));
+                PROBE(sigsegv_frames, sig, site, addr, 1);
+                telemetry_record(STEAMFIX_EV_SIGSEGV, STEAMFIX_PATH_FRAMES_1, sig, site, addr);
+                return;
+            }
+            break;
+        }
+        pass_on(sig, info, ucontext, STEAMFIX_EV_SIGSEGV, STEAMFIX_PATH_RERAISE, site, addr);
+        return;
+    }
+
+    /* Case 2: read/write to NULL — return 0 from current function */
+    if (addr < 0x10000) {
+        struct profile_site *prof;
+        if (!site_allowed(rip, STEAMFIX_SITE_DEREF, &prof)) {
+            pass_on(sig, info, ucontext, STEAMFIX_EV_SIGSEGV, STEAMFIX_PATH_UNLISTED, rip, addr);
+            return;
+        }
+        switch (storm_level(rip, addr, prof)) {
+        case STORM_NORMAL:
+            if (return_via_frames(ctx, 1, 0)) {
+                PROBE(sigsegv_frames, sig, rip, addr, 1);
+                telemetry_record(STEAMFIX_EV_SIGSEGV, STEAMFIX_PATH_FRAMES_1, sig, rip, addr);
+            } else {
+                return_via_rsp(ctx, rsp);
+                PROBE(sigsegv_return, sig, rip, addr, 0);
+                telemetry_record(STEAMFIX_EV_SIGSEGV, STEAMFIX_PATH_RETURN, sig, rip, addr);
+            }
+            return;
+        case STORM_ALTERNATE:
+            if (return_via_frames(ctx, 2, 0)) {
+                PROBE(sigsegv_frames, sig, rip, addr, 2);
+                telemetry_record(STEAMFIX_EV_SIGSEGV, STEAMFIX_PATH_FRAMES_2, sig, rip, addr);
+                return;
+            }
+            break;
+        }
+        pass_on(sig, info, ucontext, STEAMFIX_EV_SIGSEGV, STEAMFIX_PATH_RERAISE, rip, addr);
+        return;
+    }
+
+    /* Non-NULL fault — genuine crash, restore default and re-raise */
+    pass_on(sig, info, ucontext, STEAMFIX_EV_SIGSEGV, STEAMFIX_PATH_RERAISE, rip, addr);
+}
+
+/* ── SIGTRAP/SIGILL: safety net for NOTREACHED/IMMEDIATE_CRASH ───── */
+static void crash_handler(int sig, siginfo_t *info, void *ucontext) {
+    ucontext_t *ctx = (ucontext_t *)ucontext;
+    uint64_t rip = ctx->uc_mcontext.gregs[REG_RIP];
+    uint64_t addr = (uintptr_t)info->si_addr;
+    uint8_t *insn = (uint8_t *)rip;
+
+    PROBE(crash_entry, sig, rip, addr, 0);
+    altstack_install();
+
+    int is_crash = (insn[0] == 0xcc)                       /* int3  */
+                || (insn[0] == 0x0f && insn[1] == 0x0b);   /* ud2   */
+
+    if (is_crash) {
+        /*
+         * NOTREACHED stub layout:  push rbp; mov rbp,rsp; int3; ud2; int3
+         * When we land here the stub has set up its own frame.
+         * Returning to the direct caller (the function that called NOTREACHED)
+         * often causes infinite loops because that caller retries.
+         * Instead, skip TWO frames — return to the caller's caller.
+         * If the caller's caller keeps landing us back here, skip THREE.
+         * rip is past an int3 but on a ud2, which matters for the CFI lookup.
+         */
+        struct profile_site *prof;
+        const uint8_t *stub = trap_stub(rip, sig);
+        uint32_t kind = stub ? STEAMFIX_SITE_STUB : STEAMFIX_SITE_TRAP;
+        if (!site_allowed(rip, kind, &prof)) {
+            pass_on(sig, info, ucontext, STEAMFIX_EV_CRASH, STEAMFIX_PATH_UNLISTED, rip, addr);
+            return;
+        }
+        hotpatch_resume(ctx, stub);
+        switch (storm_level(rip, addr, prof)) {
+        case STORM_NORMAL:
+            if (hotpatch_observe(ctx, sig, rip))
+                telemetry_record(STEAMFIX_EV_CRASH, STEAMFIX_PATH_PATCHED, sig, rip, addr);
+            if (return_via_frames(ctx, 2, sig == SIGTRAP)) {
+                PROBE(crash_frames, sig, rip, addr, 2);
+                telemetry_record(STEAMFIX_EV_CRASH, STEAMFIX_PATH_FRAMES_2, sig, rip, addr);
+                return;
+            }
+            /* Single-frame fallback */
+            if (return_via_frames(ctx, 1, sig == SIGTRAP)) {
+                PROBE(crash_frames, sig, rip, addr, 1);
+                telemetry_record(STEAMFIX_EV_CRASH, STEAMFIX_PATH_FRAMES_1, sig, rip, addr);
+                return;
+            }
+            break;
+        case STORM_ALTERNATE:
+            if (return_via_frames(ctx, 3, sig == SIGTRAP)) {
+                PROBE(crash_frames, sig, rip, addr, 3);
+                telemetry_record(STEAMFIX_EV_CRASH, STEAMFIX_PATH_FRAMES_3, sig, rip, addr);
+                return;
+            }
+            break;
+        }
+    }
+
+    /* Not a crash stub (or a storm) — restore default */
+    pass_on(sig, info, ucontext, STEAMFIX_EV_CRASH, STEAMFIX_PATH_RERAISE, rip, addr);
+}
+
+/* ── sigaction interception: prevent crashpad from overriding us ──── */
+/*
+ * Chrome's crashpad installs its own SIGSEGV/SIGTRAP/SIGILL handlers
+ * on startup, overriding ours. We intercept sigaction() and refuse to
+ * replace our handlers for those three signals; what the caller asked
+ * for goes to its virtual disposition instead.
+ */
+#ifdef STEAMFIX_MINIMAL
+#ifndef SA_RESTORER
+#define SA_RESTORER 0x04000000
+#endif
+
+/* What rt_sigaction takes: a restorer and a 64-bit mask, unlike libc's */
+struct kernel_sigaction {
+    void *handler;
+    unsigned long flags;
+    void (*restorer)(void);
+    uint64_t mask;
+};
+
+__attribute__((visibility("hidden"))) void steamfix_restore_rt(void);
+__asm__(
+    ".text\n"
+    ".globl steamfix_restore_rt\n"
+    ".hidden steamfix_restore_rt\n"
+    ".type  steamfix_restore_rt, @function\n"
+    "steamfix_restore_rt:\n"
+    "    movq  $" XSTR(SYS_rt_sigreturn) ", %rax\n"
+    "    syscall\n"
+    ".size  steamfix_restore_rt, .-steamfix_restore_rt\n"
+);
+
+/* libc's sigaction(), by hand */
+static int libc_sigaction(int signum, const struct sigaction *act, struct sigaction *oldact) {
+    /* glibc's own SIGCANCEL and SIGSETXID, which it refuses to hand out */
+    if (signum == 32 || signum == 33) {
+        errno = EINVAL;
+        return -1;
+    }
+    struct kernel_sigaction k, old;
+    if (act) {
+        k.handler = (void *)act->sa_handler;
+        k.flags = (unsigned long)act->sa_flags | SA_RESTORER;
+        k.restorer = steamfix_restore_rt;
+        memcpy(&k.mask, &act->sa_mask, sizeof(k.mask));
+    }
+    long ret = raw_syscall4(SYS_rt_sigaction, signum, act ? (long)&k : 0,
+                            oldact ? (long)&old : 0, sizeof(k.mask));
+    if (ret < 0) {
+        errno = (int)-ret;
+        return -1;
+    }
+    if (oldact) {
+        memset(oldact, 0, sizeof(*oldact));
+        oldact->sa_handler = (sighandler_t)old.handler;
+        oldact->sa_flags = (int)old.flags;
+        oldact->sa_restorer = old.restorer;
+        memcpy(&oldact->sa_mask, &old.mask, sizeof(old.mask));
+    }
+    return 0;
+}
+#else
+typedef int (*real_sigaction_t)(int, const struct sigaction *, struct sigaction *);
+static real_sigaction_t real_sigaction_fn = NULL;
+
+static int libc_sigaction(int signum, const struct sigaction *act, struct sigaction *oldact) {
+    return NEXT(real_sigaction_fn, "sigaction")(signum, act, oldact);
+}
+#endif
+
+STEAMFIX_EXPORT
+int sigaction(int signum, const struct sigaction *act, struct sigaction *oldact) {
+    if (__atomic_load_n(&handlers_locked, __ATOMIC_ACQUIRE) &&
+        disposition_index(signum) >= 0) {
+        if (act) {
+            PROBE(sigaction_blocked, signum, __builtin_return_address(0),
+                  act->sa_handler, act->sa_flags);
+            telemetry_record(STEAMFIX_EV_SIGACTION, STEAMFIX_PATH_BLOCKED, signum,
+                             (uintptr_t)__builtin_return_address(0),
+                             (uintptr_t)act->sa_handler);
+        }
+        disposition_set(signum, act, oldact);
+        return 0;   /* pretend we set it */
+    }
+    int ret = libc_sigaction(signum, act, oldact);
+    if (ret != 0)
+        set_caller_errno(errno);
+    return ret;
+}
+
+STEAMFIX_EXPORT
+sighandler_t signal(int signum, sighandler_t handler) {
+    struct sigaction sa_old, sa_new;
+    memset(&sa_new, 0, sizeof(sa_new));
+    sa_new.sa_handler = handler;
+    sa_new.sa_flags = SA_RESTART;       /* glibc's BSD semantics */
+    sigemptyset(&sa_new.sa_mask);
+
+    if (__atomic_load_n(&handlers_locked, __ATOMIC_ACQUIRE) &&
+        disposition_index(signum) >= 0) {
+        PROBE(signal_blocked, signum, __builtin_return_address(0), handler, 0);
+        telemetry_record(STEAMFIX_EV_SIGNAL, STEAMFIX_PATH_BLOCKED, signum,
+                         (uintptr_t)__builtin_return_address(0),
+                         (uintptr_t)handler);
+        disposition_set(signum, &sa_new, &sa_old);
+        return sa_old.sa_handler;
+    }
+
+    if (libc_sigaction(signum, &sa_new, &sa_old) != 0) {
+        set_caller_errno(errno);
+        return SIG_ERR;
+    }
+    return sa_old.sa_handler;
+}
+
+/* ── clone3 interception: safety net for seccomp ─────────────────── */
+/*
+ * Kernel 6.13+ prefers clone3() but Chrome 126's seccomp sandbox
+ * blocks it. Returning ENOSYS forces glibc to fall back to clone().
+ *
+ * Chromium calls syscall() explicitly all the time (gettid, futex,
+ * memfd_create, ...), so the entry point is a few instructions of
+ * assembly that issue every other syscall directly, exactly like libc's
+ * own syscall(): no symbol lookup, no va_arg, no indirect call. Only
+ * clone3 and clone take the C path below.
+ */
+#ifndef STEAMFIX_MINIMAL
+typedef long (*syscall_fn_t)(long, ...);
+static syscall_fn_t real_syscall = NULL;
+#endif
+static int clone3_in_kernel = 0;    /* seccomp filter denies it for us */
+
+__attribute__((visibility("hidden"), used))
+long steamfix_syscall_slow(long number, long a1, long a2, long a3,
+                           long a4, long a5, long a6) {
+    if (number == SYS_clone3 && !clone3_in_kernel) {
+        PROBE(clone3_enosys, 0, __builtin_return_address(0), 0, 0);
+        telemetry_record(STEAMFIX_EV_CLONE3, STEAMFIX_PATH_ENOSYS, 0,
+                         (uintptr_t)__builtin_return_address(0), 0);
+        set_caller_errno(ENOSYS);
+        return -1;
+    }
+
+#ifdef STEAMFIX_MINIMAL
+    long ret = raw_syscall6(number, a1, a2, a3, a4, a5, a6);
+    if (ret < 0 && ret > -4096) {
+        set_caller_errno((int)-ret);
+        ret = -1;
+    }
+#else
+    long ret = NEXT(real_syscall, "syscall")(number, a1, a2, a3, a4, a5, a6);
+#endif
+
+    /* Chromium forks zygote children with raw clone(), bypassing atfork */
+    if (ret == 0 && number == SYS_clone && !(a1 & (CLONE_VM | CLONE_THREAD))) {
+        telemetry_after_fork();
+        altstack_after_fork();
+    }
+    return ret;
+}
+
+__attribute__((visibility("hidden"), used))
+long steamfix_syscall_error(long ret) {
+    set_caller_errno((int)-ret);
+    return -1;
+}
+
+/* long syscall(long number, ...) — same register shuffle as glibc's */
+__asm__(
+    ".text\n"
+    ".globl syscall\n"
+    ".type  syscall, @function\n"
+    "syscall:\n"
+    "    cmpq  steamfix_syscall_trap(%rip), %rdi\n"       /* clone3 */
+    "    je    steamfix_syscall_slow\n"
+    "    cmpq  steamfix_syscall_trap+8(%rip), %rdi\n"     /* clone  */
+    "    je    steamfix_syscall_slow\n"
+    "    movq  %rdi, %rax\n"
+    "    movq  %rsi, %rdi\n"
+    "    movq  %rdx, %rsi\n"
+    "    movq  %rcx, %rdx\n"
+    "    movq  %r8,  %r10\n"
+    "    movq  %r9,  %r8\n"
+    "    movq  8(%rsp), %r9\n"
+    "    syscall\n"
+    "    cmpq  $-4095, %rax\n"
+    "    jae   1f\n"
+    "    ret\n"
+    "1:  movq  %rax, %rdi\n"
+    "    jmp   steamfix_syscall_error\n"
+    ".size  syscall, .-syscall\n"
+);
+
+/* ── clone3 denial in the kernel (STEAMFIX_CLONE3=seccomp) ───────── */
+/*
+ * Interposing syscall() only catches explicit syscall(SYS_clone3, ...);
+ * glibc's pthread_create() and posix_spawn() issue clone3 inline. With
+ * STEAMFIX_CLONE3=seccomp the constructor instead installs a seccomp
+ * filter that fails clone3 — and nothing else — with ENOSYS, for every
+ * caller and every thread, at the cost of a few BPF instructions per
+ * syscall. It stacks under Chrome's own sandbox filters: the kernel runs
+ * all of them and the strictest verdict wins.
+ *
+ * Unprivileged filters need no_new_privs, which is inherited and makes
+ * setuid binaries (e.g. a setuid bwrap) refuse to gain privileges in
+ * every descendant. That's why this is opt-in.
+ */
+static int install_clone3_filter(void) {
+    struct sock_filter filter[] = {
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(struct seccomp_data, arch)),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, AUDIT_ARCH_X86_64, 1, 0),
+        BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ALLOW),
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(struct seccomp_data, nr)),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, SYS_clone3, 1, 0),
+        BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ALLOW),
+        BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ERRNO | (ENOSYS & SECCOMP_RET_DATA)),
+    };
+    struct sock_fprog prog = {
+        .len    = sizeof(filter) / sizeof(filter[0]),
+        .filter = filter,
+    };
+
+    if (prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0) != 0)
+        return -1;
+    /* TSYNC: cover threads other constructors may already have started */
+    if (raw_syscall3(SYS_seccomp, SECCOMP_SET_MODE_FILTER,
+                     SECCOMP_FILTER_FLAG_TSYNC, (long)&prog) != 0)
+        return -1;
+    return 0;
+}
+
+#ifndef STEAMFIX_MINIMAL
+/* ── VA-API pre-check: fail vaInitialize() before libva faults ───── */
+/*
+ * libva only crashes when no backend driver (*_drv_video.so) can be
+ * loaded. We look for the driver libva is going to pick ourselves and,
+ * if it isn't there, return the same error libva returns for a missing
+ * driver, without ever entering libva. Chrome then disables VA-API
+ * and carries on; no SIGSEGV round-trip on the startup path.
+ */
+typedef int   VAStatus;
+typedef void *VADisplay;
+#define VA_STATUS_SUCCESS        0x00000000
+#define VA_STATUS_ERROR_UNKNOWN  0xFFFFFFFF
+
+typedef VAStatus  (*va_initialize_t)(VADisplay, int *, int *);
+typedef VADisplay (*va_get_display_drm_t)(int);
+static va_initialize_t      real_va_initialize = NULL;
+static va_get_display_drm_t real_va_get_display_drm = NULL;
+
+/* DRM_IOCTL_VERSION, from <drm/drm.h>, which isn't always installed */
+struct va_drm_version {
+    int version_major, version_minor, version_patchlevel;
+    size_t name_len;  char *name;
+    size_t date_len;  char *date;
+    size_t desc_len;  char *desc;
+};
+#define VA_DRM_IOCTL_VERSION _IOWR('d', 0x00, struct va_drm_version)
+
+/* Kernel DRM driver → libva driver names, as in libva's va_drm_utils.c */
+static const struct { const char *drm; const char *va[3]; } va_drm_map[] = {
+    { "i915",       { "iHD", "i965", NULL } },
+    { "xe",         { "iHD", NULL } },
+    { "amdgpu",     { "radeonsi", NULL } },
+    { "radeon",     { "r600", "radeonsi", NULL } },
+    { "nvidia-drm", { "nvidia", NULL } },
+    { "nouveau",    { "nouveau", NULL } },
+};
+
+static const char *const va_default_dirs[] = {
+    "/usr/lib/x86_64-linux-gnu/dri",
+    "/usr/lib64/dri",
+    "/usr/lib/dri",
+    "/usr/local/lib/dri",
+    NULL,
+};
+
+/* Displays handed out by vaGetDisplayDRM() and their kernel driver */
+#define VA_MAX_DISPLAYS 8
+static struct { VADisplay dpy; char drm[32]; } va_displays[VA_MAX_DISPLAYS];
+static unsigned va_display_next = 0;
+
+/*
+ * Which drivers libva could load: the names of the *_drv_video.so in
+ * LIBVA_DRIVERS_PATH (or libva's default dirs), one per line. Scanning
+ * those directories in each of Steam's processes is wasted I/O, so the
+ * list is cached in $XDG_CACHE_HOME/steamfix/, in a file named after a
+ * hash of what decides it: the kernel release, the NVIDIA kernel
+ * driver's version, the inode and mtime of libva.so.2 (the first in the
+ * default library dirs; stat() follows the symlink, so an upgrade
+ * changes them), the search path and each directory's inode and mtime —
+ * installing or removing a driver changes the last. A hit costs those
+ * stat()s and one read().
+ */
+#define VA_MAX_DIRS     16
+#define VA_NAMES_MAX    2048
+
+struct va_search {
+    char buf[1024];
+    const char *dir[VA_MAX_DIRS];
+    unsigned count;
+};
+
+static char va_names[VA_NAMES_MAX];
+static uint64_t va_names_for;           /* FNV-1a of the LIBVA_DRIVERS_PATH */
+static int va_names_valid;
+static pthread_mutex_t va_names_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void va_search_dirs(struct va_search *s, const char *paths) {
+    s->count = 0;
+    if (!paths || !*paths) {
+        for (int i = 0; va_default_dirs[i]; i++)
+            s->dir[s->count++] = va_default_dirs[i];
+        return;
+    }
+    snprintf(s->buf, sizeof(s->buf), "%s", paths);
+    for (char *p = s->buf; *p && s->count < VA_MAX_DIRS; ) {
+        size_t len = strcspn(p, ":");
+        if (len)
+            s->dir[s->count++] = p;
+        p += len;
+        if (*p)
+            *p++ = 0;
+    }
+}
+
+static uint64_t va_fold(uint64_t h, uint64_t v) {
+    return steamfix_fnv1a(h, &v, sizeof(v));
+}
+
+static uint64_t va_names_key(const struct va_search *s) {
+    uint64_t h = STEAMFIX_FNV_BASIS;
+    struct utsname u;
+    if (uname(&u) == 0)
+        h = steamfix_fnv1a(h, u.release, strlen(u.release));
+
+    char version[128];
+    int fd = open("/sys/module/nvidia/version", O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        ssize_t n = read(fd, version, sizeof(version));
+        close(fd);
+        if (n > 0)
+            h = steamfix_fnv1a(h, version, (size_t)n);
+    }
+    /* libva itself, next to the default driver dirs: the first one found */
+    for (int i = 0; va_default_dirs[i]; i++) {
+        char lib[64];
+        struct stat st;
+        snprintf(lib, sizeof(lib), "%.*s/libva.so.2",
+                 (int)(strlen(va_default_dirs[i]) - 4), va_default_dirs[i]);
+        if (stat(lib, &st) == 0) {
+            h = va_fold(h, st.st_ino);
+            h = va_fold(h, (uint64_t)st.st_mtim.tv_sec);
+            h = va_fold(h, (uint64_t)st.st_mtim.tv_nsec);
+            break;
+        }
+    }
+
+    for (unsigned i = 0; i < s->count; i++) {
+        struct stat st;
+        h = steamfix_fnv1a(h, s->dir[i], strlen(s->dir[i]) + 1);
+        if (stat(s->dir[i], &st) == 0) {
+            h = va_fold(h, st.st_ino);
+            h = va_fold(h, (uint64_t)st.st_mtim.tv_sec);
+            h = va_fold(h, (uint64_t)st.st_mtim.tv_nsec);
+        }
+    }
+    return h;
+}
+
+static int va_names_path(char *path, size_t size, uint64_t key, int mkdirs) {
+    char file[32];
+    snprintf(file, sizeof(file), "va-drivers-%016llx", (unsigned long long)key);
+    return cache_path(path, size, file, mkdirs);
+}
+
+static void va_names_scan(const struct va_search *s, char *names, size_t size) {
+    size_t used = 0;
+    names[0] = 0;
+    for (unsigned i = 0; i < s->count; i++) {
+        DIR *d = opendir(s->dir[i]);
+        if (!d)
+            continue;
+        struct dirent *e;
+        while ((e = readdir(d)) != NULL) {
+            size_t n = strlen(e->d_name);
+            if (n <= 13 || strcmp(e->d_name + n - 13, "_drv_video.so") != 0)
+                continue;
+            n -= 13;
+            if (used + n + 1 >= size)
+                break;
+            memcpy(names + used, e->d_name, n);
+            names[used + n] = '\n';
+            used += n + 1;
+        }
+        closedir(d);
+    }
+    names[used] = 0;
+}
+
+/* The driver list for the current LIBVA_DRIVERS_PATH */
+static const char *va_driver_names(void) {
+    const char *paths = getenv("LIBVA_DRIVERS_PATH");
+    uint64_t want = paths ? steamfix_fnv1a(STEAMFIX_FNV_BASIS, paths, strlen(paths)) : 0;
+
+    pthread_mutex_lock(&va_names_lock);
+    if (va_names_valid && va_names_for == want) {
+        pthread_mutex_unlock(&va_names_lock);
+        return va_names;
+    }
+
+    struct va_search s;
+    va_search_dirs(&s, paths);
+    uint64_t key = va_names_key(&s);
+    char path[512];
+    int cached = 0;
+    if (va_names_path(path, sizeof(path), key, 0)) {
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd >= 0) {
+            ssize_t n = read(fd, va_names, sizeof(va_names) - 1);
+            close(fd);
+            cached = n == 0 || (n > 0 && va_names[n - 1] == '\n');
+            va_names[cached ? n : 0] = 0;
+        }
+    }
+    if (!cached) {
+        va_names_scan(&s, va_names, sizeof(va_names));
+        char tmp[544];
+        if (va_names_path(path, sizeof(path), key, 1) &&
+            snprintf(tmp, sizeof(tmp), "%s.%d", path, (int)getpid()) < (int)sizeof(tmp)) {
+            int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+            if (fd >= 0) {
+                size_t n = strlen(va_names);
+                int ok = write(fd, va_names, n) == (ssize_t)n;
+                close(fd);
+                if (!ok || rename(tmp, path) != 0)
+                    unlink(tmp);
+            }
+        }
+    }
+    va_names_for = want;
+    va_names_valid = 1;
+    pthread_mutex_unlock(&va_names_lock);
+    return va_names;
+}
+
+/* Could libva load <name>_drv_video.so (any driver if !name)? */
+static int va_driver_present(const char *name) {
+    const char *names = va_driver_names();
+    if (!name)
+        return names[0] != 0;
+    size_t len = strlen(name);
+    for (const char *p = names; *p; p = strchr(p, '\n') + 1)
+        if (strncmp(p, name, len) == 0 && p[len] == '\n')
+            return 1;
+    return 0;
+}
+
+/* Is one of the libva drivers for kernel DRM driver `drm` there? */
+static int va_drm_backend_present(const char *drm) {
+    for (size_t m = 0; m < sizeof(va_drm_map) / sizeof(va_drm_map[0]); m++) {
+        if (strcmp(drm, va_drm_map[m].drm) != 0)
+            continue;
+        for (int k = 0; va_drm_map[m].va[k]; k++)
+            if (va_driver_present(va_drm_map[m].va[k]))
+                return 1;
+        return 0;
+    }
+    return va_driver_present(drm);
+}
+
+/* The kernel DRM driver behind `fd` into name[32], "" if it won't say */
+static void va_drm_name(int fd, char *name) {
+    struct va_drm_version v;
+    memset(&v, 0, sizeof(v));
+    memset(name, 0, 32);
+    v.name = name;
+    v.name_len = 31;
+    if (ioctl(fd, VA_DRM_IOCTL_VERSION, &v) != 0)
+        name[0] = 0;
+}
+
+/*
+ * The kernel driver of the display Chromium is going to open, before
+ * it does: like its VADisplayState, the first render node that isn't
+ * vgem. Looked up once per process. If no node can be opened (a
+ * sandbox, no /dev/dri), it is taken to be NVIDIA's, the one the crash
+ * needs.
+ */
+#define VA_RENDER_NODES 16
+
+static char va_render_drm[32];
+static int va_render_known;
+
+static const char *va_render_driver(void) {
+    if (__atomic_load_n(&va_render_known, __ATOMIC_ACQUIRE))
+        return va_render_drm;
+    char found[32] = "nvidia-drm";
+    for (int i = 0; i < VA_RENDER_NODES; i++) {
+        char path[32], name[32];
+        snprintf(path, sizeof(path), "/dev/dri/renderD%d", 128 + i);
+        int fd = open(path, O_RDWR | O_CLOEXEC);
+        if (fd < 0)
+            continue;
+        va_drm_name(fd, name);
+        close(fd);
+        if (name[0] && strcmp(name, "vgem") != 0) {
+            memcpy(found, name, sizeof(found));
+            break;
+        }
+    }
+    pthread_mutex_lock(&va_names_lock);
+    if (!va_render_known) {
+        memcpy(va_render_drm, found, sizeof(found));
+        __atomic_store_n(&va_render_known, 1, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&va_names_lock);
+    return va_render_drm;
+}
+
+/* Would vaInitialize(dpy) find a backend driver to load? */
+static int va_backend_available(VADisplay dpy) {
+    const char *forced = getenv("LIBVA_DRIVER_NAME");
+    if (forced && *forced)
+        return va_driver_present(forced);
+
+    for (unsigned i = 0; i < VA_MAX_DISPLAYS; i++)
+        if (dpy && __atomic_load_n(&va_displays[i].dpy, __ATOMIC_ACQUIRE) == dpy)
+            return va_drm_backend_present(va_displays[i].drm);
+
+    /* X11/Wayland display or one we didn't see created: it is on the
+     * render node Chromium would open, and needs that node's driver */
+    return va_drm_backend_present(va_render_driver());
+}
+
+/*
+ * With no driver for the display Chromium opens (see below), libva is
+ * pointed at the null driver built next to this library
+ * (steamfix_null_drv_video.c): vaInitialize() then succeeds at once with
+ * a driver that has no profiles. steamwebhelper children inherit the
+ * variables, so only the first process has to look; exec_scrub() takes
+ * them out of the environment of anything else it starts.
+ * STEAMFIX_VA_NULL=0 turns this off.
+ */
+#define VA_NULL_DRIVER  "steamfix_null"
+
+static int va_null_driver_in_use(void) {
+    const char *forced = getenv("LIBVA_DRIVER_NAME");
+    return forced && strcmp(forced, VA_NULL_DRIVER) == 0;
+}
+
+/*
+ * Would a display of kernel driver `drm` get a real driver (not ours)?
+ * Any driver being installed isn't enough: Mesa's come with most
+ * distributions, and none of them serves an NVIDIA display.
+ */
+static int va_real_driver_for(const char *drm) {
+    if (va_null_driver_in_use())
+        return 0;
+    const char *forced = getenv("LIBVA_DRIVER_NAME");
+    if (forced && *forced)
+        return va_driver_present(forced);
+    return va_drm_backend_present(drm);
+}
+
+/* ... and the display Chromium is going to open? */
+static int va_display_driver_available(void) {
+    return va_real_driver_for(va_render_driver());
+}
+
+static void va_null_driver_init(void) {
+    const char *opt = getenv("STEAMFIX_VA_NULL");
+    if ((opt && opt[0] == '0') || getenv("LIBVA_DRIVER_NAME") || va_display_driver_available())
+        return;
+    char dir[512];
+    if (!self_path(dir, sizeof(dir), VA_NULL_DRIVER "_drv_video.so") ||
+        access(dir, R_OK) != 0)
+        return;
+    *strrchr(dir, '/') = 0;
+    /* Appended to the user's own search path, so it can be taken off again */
+    const char *paths = getenv("LIBVA_DRIVERS_PATH");
+    char joined[1024];
+    if (paths && *paths) {
+        if (snprintf(joined, sizeof(joined), "%s:%s", paths, dir) >= (int)sizeof(joined))
+            return;
+        setenv("LIBVA_DRIVERS_PATH", joined, 1);
+    } else {
+        setenv("LIBVA_DRIVERS_PATH", dir, 1);
+    }
+    setenv("LIBVA_DRIVER_NAME", VA_NULL_DRIVER, 1);
+}
+
+/*
+ * Lazy libva (STEAMFIX_VA_STUB=1). Without a usable driver, libva is only
+ * ever loaded to fail, yet Chromium dlopen()s libva.so.2 and
+ * libva-drm.so.2 (and libdrm with them) in the zygote, and every process
+ * forked from it inherits those mappings. So dlopen() of a libva library
+ * instead returns a handle to this one. dlsym() on that handle finds our
+ * vaGetDisplayDRM(), which has no libva to call and returns no display,
+ * and nothing for the rest of the API. Chromium's generated stubs take
+ * either result as "VA-API unavailable" and decode in software. libva,
+ * libdrm and their relocations are never loaded in the whole tree.
+ * A libva already loaded, or a real driver for the display Chromium
+ * opens (va_display_driver_available()), is used as usual.
+ */
+static int va_is_libva(const char *file) {
+    size_t len;
+    const char *name = elf_basename(file, &len);
+    return strncmp(name, "libva.so", 8) == 0 ||
+           (strncmp(name, "libva-", 6) == 0 && strstr(name, ".so"));
+}
+
+static void *va_stub_dlopen(const char *file, int mode) {
+    const char *opt = getenv("STEAMFIX_VA_STUB");
+    if (!opt || opt[0] != '1' || !file || (mode & RTLD_NOLOAD) || !va_is_libva(file))
+        return NULL;
+    if (va_display_driver_available())
+        return NULL;
+
+    real_dlopen_t real = NEXT(real_dlopen_fn, "dlopen");
+    void *handle = real(file, mode | RTLD_NOLOAD);
+    const char *self = self_object();
+    if (handle || !self)
+        return handle;
+    handle = real(self, RTLD_LAZY | RTLD_NOLOAD);
+    PROBE(va_stub, 0, file, handle, 0);
+    return handle;
+}
+
+STEAMFIX_EXPORT
+VADisplay vaGetDisplayDRM(int fd) {
+    va_get_display_drm_t real = NEXT(real_va_get_display_drm, "vaGetDisplayDRM");
+    if (!real)
+        return NULL;
+
+    VADisplay dpy = real(fd);
+    if (!dpy)
+        return dpy;
+
+    char name[32];
+    va_drm_name(fd, name);
+    if (name[0]) {
+        unsigned i = __atomic_fetch_add(&va_display_next, 1, __ATOMIC_RELAXED)
+                   % VA_MAX_DISPLAYS;
+        memcpy(va_displays[i].drm, name, sizeof(name));
+        __atomic_store_n(&va_displays[i].dpy, dpy, __ATOMIC_RELEASE);
+    }
+    return dpy;
+}
+
+STEAMFIX_EXPORT
+VAStatus vaInitialize(VADisplay dpy, int *major_version, int *minor_version) {
+    uint64_t start = __rdtsc();
+    uintptr_t caller = (uintptr_t)__builtin_return_address(0);
+    if (!disarmed && !va_backend_available(dpy)) {
+        telemetry_record(STEAMFIX_EV_VA_INIT, STEAMFIX_PATH_FAILED, 0, caller,
+                         __rdtsc() - start);
+        return (VAStatus)VA_STATUS_ERROR_UNKNOWN;   /* what libva returns */
+    }
+
+    va_initialize_t real = NEXT(real_va_initialize, "vaInitialize");
+    if (!real)
+        return (VAStatus)VA_STATUS_ERROR_UNKNOWN;
+    VAStatus status = real(dpy, major_version, minor_version);
+    telemetry_record(STEAMFIX_EV_VA_INIT, STEAMFIX_PATH_PASSED, status, caller,
+                     __rdtsc() - start);
+    return status;
+}
+
+/* ── execve interception: steer steamwebhelper off VA-API ────────── */
+/*
+ * Each GPU process crash before Chrome gives up costs startup time, and
+ * it is cheaper still not to reach vaInitialize() at all. When Steam
+ * (or steamwebhelper itself, re-exec'ing /proc/self/exe) starts
+ * steamwebhelper, extra Chromium switches are added to its command line:
+ *
+ *   STEAMFIX_WEBHELPER_ARGS unset   WEBHELPER_DEFAULT_ARGS, but only if
+ *                                   the display Chromium opens has no
+ *                                   VA-API driver (the null driver
+ *                                   doesn't count)
+ *   STEAMFIX_WEBHELPER_ARGS="..."   these switches, always ("" = none)
+ *
+ * A switch the command line already has is left alone, except that
+ * --enable-features=/--disable-features= lists are merged. Everything
+ * lives on the stack, as execve() may run in a vfork() child.
+ */
+#define WEBHELPER_DEFAULT_ARGS  "--disable-accelerated-video-decode " \
+                                "--disable-features=VaapiVideoDecoder,VaapiVideoDecodeLinuxGL"
+#define WEBHELPER_MAX_ARGC      256
+#define WEBHELPER_MAX_SWITCHES  16
+
+struct webhelper_argv {
+    char *argv[WEBHELPER_MAX_ARGC];
+    char switches[1024];            /* the configured switches, split     */
+    char merged[4096];              /* merged feature lists               */
+};
+
+static int webhelper_target(const char *path) {
+    if (!path)
+        return 0;
+    if (strcmp(path, "/proc/self/exe") == 0)
+        path = module_exe;
+    size_t len;
+    const char *name = elf_basename(path, &len);
+    return len == 14 && memcmp(name, "steamwebhelper", 14) == 0;
+}
+
+/* `argv` with the configured switches added, or `argv` itself */
+static char *const *webhelper_rewrite(const char *path, char *const argv[],
+                                      struct webhelper_argv *w) {
+    if (!argv || !argv[0] || !webhelper_target(path))
+        return argv;
+    const char *config = getenv("STEAMFIX_WEBHELPER_ARGS");
+    if (!config)
+        config = policy_webhelper_args();
+    if (!config) {
+        if (va_display_driver_available())
+            return argv;
+        config = WEBHELPER_DEFAULT_ARGS;
+    }
+    if (strlen(config) >= sizeof(w->switches))
+        return argv;
+    strcpy(w->switches, config);
+
+    char *switches[WEBHELPER_MAX_SWITCHES];
+    size_t nswitches = 0;
+    for (char *p = w->switches; *p && nswitches < WEBHELPER_MAX_SWITCHES; ) {
+        p += strspn(p, " \t");
+        if (!*p)
+            break;
+        switches[nswitches++] = p;
+        p += strcspn(p, " \t");
+        if (*p)
+            *p++ = 0;
+    }
+
+    size_t argc = 0;
+    while (argv[argc])
+        argc++;
+    if (argc + nswitches >= WEBHELPER_MAX_ARGC)
+        return argv;
+
+    /* Ours go right after argv[0], ahead of any "--"; the rest follow */
+    char **rest = &w->argv[1 + nswitches];
+    memcpy(rest, &argv[1], argc * sizeof(argv[0]));     /* with the NULL */
+    size_t added = 0, used = 0;
+    for (size_t i = 0; i < nswitches; i++) {
+        const char *sw = switches[i];
+        const char *eq = strchr(sw, '=');
+        size_t name_len = eq ? (size_t)(eq - sw) + 1 : strlen(sw);
+        int list = eq && (strncmp(sw, "--enable-features=", name_len) == 0 ||
+                          strncmp(sw, "--disable-features=", name_len) == 0);
+
+        /* Chromium takes the last occurrence, so that's the one to merge into */
+        char **have = NULL;
+        for (size_t k = 0; rest[k]; k++)
+            if (strncmp(rest[k], sw, name_len) == 0 &&
+                (eq || rest[k][name_len] == 0 || rest[k][name_len] == '='))
+                have = &rest[k];
+
+        if (!have) {
+            w->argv[1 + added++] = (char *)sw;
+        } else if (list) {
+            int n = snprintf(w->merged + used, sizeof(w->merged) - used, "%s,%s",
+                             *have, eq + 1);
+            if (n > 0 && (size_t)n < sizeof(w->merged) - used) {
+                *have = w->merged + used;
+                used += (size_t)n + 1;
+            }
+        }
+    }
+    /* Close the gap left by switches that were already there */
+    w->argv[0] = argv[0];
+    memmove(&w->argv[1 + added], rest, argc * sizeof(argv[0]));
+    return w->argv;
+}
+
+/*
+ * Games are started from Steam's process tree with LD_PRELOAD intact, and
+ * even disarmed the library costs each of their processes a mapping, its
+ * relocations and a constructor. When an exec's environment has a
+ * SteamAppId/SteamGameId — Steam is launching a game — and the program
+ * isn't steamwebhelper, the library's own entry is taken out of the
+ * child's LD_PRELOAD (the variable is dropped if nothing is left). The
+ * first 64-bit process of the launch does it, so everything below it
+ * starts clean. STEAMFIX_SCRUB=0 keeps the preload.
+ *
+ * Likewise the null driver's LIBVA_DRIVER_NAME and its directory in
+ * LIBVA_DRIVERS_PATH are only meant for steamwebhelper: any other program
+ * gets the environment it would have had, with or without a game.
+ */
+#define EXEC_MAX_ENVC   1024
+
+struct exec_env {
+    char *envp[EXEC_MAX_ENVC];
+    char preload[4096];
+    char va_path[1024];
+};
+
+static int exec_env_is(const char *entry, const char *name, size_t len) {
+    return strncmp(entry, name, len) == 0 && entry[len] == '=';
+}
+
+/* `envp` without the null driver's variables, if they are there */
+static char *const *exec_scrub_va(char *const envp[], struct exec_env *e) {
+    char dir[512];
+    size_t envc = 0, name = (size_t)-1, path = (size_t)-1;
+    if (!self_path(dir, sizeof(dir), VA_NULL_DRIVER "_drv_video.so"))
+        return envp;
+    *strrchr(dir, '/') = 0;
+    for (; envp[envc]; envc++) {
+        if (strcmp(envp[envc], "LIBVA_DRIVER_NAME=" VA_NULL_DRIVER) == 0)
+            name = envc;
+        else if (exec_env_is(envp[envc], "LIBVA_DRIVERS_PATH", 18))
+            path = envc;
+    }
+    if (name == (size_t)-1 || envc >= EXEC_MAX_ENVC)
+        return envp;
+
+    /* "<user's>:<dir>" goes back to "<user's>", "<dir>" away entirely */
+    char *restored = NULL;
+    if (path != (size_t)-1) {
+        const char *v = envp[path] + 19;
+        size_t len = strlen(v), dlen = strlen(dir);
+        if (len == dlen && memcmp(v, dir, dlen) == 0) {
+            restored = NULL;
+        } else if (len > dlen && v[len - dlen - 1] == ':' && strcmp(v + len - dlen, dir) == 0 &&
+                   len - dlen - 1 + 20 <= sizeof(e->va_path)) {
+            memcpy(e->va_path, envp[path], 19 + len - dlen - 1);
+            e->va_path[19 + len - dlen - 1] = 0;
+            restored = e->va_path;
+        } else {
+            restored = envp[path];      /* not ours */
+        }
+    }
+
+    size_t k = 0;
+    for (size_t i = 0; i < envc; i++)
+        if (i == path) {
+            if (restored)
+                e->envp[k++] = restored;
+        } else if (i != name) {
+            e->envp[k++] = envp[i];
+        }
+    e->envp[k] = NULL;
+    return e->envp;
+}
+
+/* `envp` without this library in LD_PRELOAD if it starts a game, or `envp` */
+static char *const *exec_scrub_preload(char *const envp[], struct exec_env *e) {
+    const char *opt = getenv("STEAMFIX_SCRUB");
+    const char *self = self_object();
+    if ((opt && opt[0] == '0') || !self)
+        return envp;
+
+    size_t envc = 0, preload = (size_t)-1;
+    int game = 0;
+    for (; envp[envc]; envc++) {
+        const char *v = envp[envc];
+        if (exec_env_is(v, "LD_PRELOAD", 10))
+            preload = envc;
+        else if ((exec_env_is(v, "SteamAppId", 10) || exec_env_is(v, "SteamGameId", 11)) &&
+                 v[strcspn(v, "=") + 1] && strcmp(v + strcspn(v, "=") + 1, "0") != 0)
+            game = 1;
+    }
+    if (!game || preload == (size_t)-1 || envc >= EXEC_MAX_ENVC)
+        return envp;
+
+    /* ld.so splits LD_PRELOAD on ':' and ' '; ours is matched by file name */
+    size_t self_len, used = 0;
+    const char *self_name = elf_basename(self, &self_len);
+    char *out = e->preload + 11;
+    int dropped = 0;
+    for (const char *p = envp[preload] + 11; *p; ) {
+        size_t n = strcspn(p, ": ");
+        const char *name = p + n;
+        while (name > p && name[-1] != '/')
+            name--;
+        if (n && (size_t)(p + n - name) == self_len && memcmp(name, self_name, self_len) == 0) {
+            dropped = 1;
+        } else if (n) {
+            if (used + n + 2 > sizeof(e->preload) - 11)
+                return envp;
+            if (used)
+                out[used++] = ':';
+            memcpy(out + used, p, n);
+            used += n;
+        }
+        p += n;
+        if (*p)
+            p++;
+    }
+    if (!dropped)
+        return envp;
+
+    size_t k = 0;
+    for (size_t i = 0; i < envc; i++)
+        if (i != preload)
+            e->envp[k++] = envp[i];
+    if (used) {
+        memcpy(e->preload, "LD_PRELOAD=", 11);
+        out[used] = 0;
+        e->envp[k++] = e->preload;
+    }
+    e->envp[k] = NULL;
+    return e->envp;
+}
+
+/* What `path` is started with instead of `envp`: see above */
+static char *const *exec_scrub(const char *path, char *const envp[], struct exec_env *e) {
+    if (!envp || webhelper_target(path))
+        return envp;
+    return exec_scrub_va(exec_scrub_preload(envp, e), e);
+}
+
+/* The timeline shows which program each exec started, and from where */
+static void exec_record(const char *path, void *caller) {
+    size_t len = 0;
+    const char *name = path ? elf_basename(path, &len) : "";
+    telemetry_record_named(STEAMFIX_EV_EXEC, 0, 0, (uintptr_t)caller, 0, name, len);
+}
+
+typedef int (*real_execve_t)(const char *, char *const[], char *const[]);
+typedef int (*real_execvpe_t)(const char *, char *const[], char *const[]);
+typedef int (*real_execv_t)(const char *, char *const[]);
+typedef int (*real_posix_spawn_t)(pid_t *, const char *, const posix_spawn_file_actions_t *,
+                                  const posix_spawnattr_t *, char *const[], char *const[]);
+static real_execve_t      real_execve_fn       = NULL;
+static real_execvpe_t     real_execvpe_fn      = NULL;
+static real_execv_t       real_execv_fn        = NULL;
+static real_execv_t       real_execvp_fn       = NULL;
+static real_posix_spawn_t real_posix_spawn_fn  = NULL;
+static real_posix_spawn_t real_posix_spawnp_fn = NULL;
+
+extern char **environ;
+
+STEAMFIX_EXPORT
+int execve(const char *path, char *const argv[], char *const envp[]) {
+    struct webhelper_argv w;
+    struct exec_env e;
+    exec_record(path, __builtin_return_address(0));
+    return NEXT(real_execve_fn, "execve")(path, webhelper_rewrite(path, argv, &w),
+                                          exec_scrub(path, envp, &e));
+}
+
+STEAMFIX_EXPORT
+int execv(const char *path, char *const argv[]) {
+    struct webhelper_argv w;
+    struct exec_env e;
+    exec_record(path, __builtin_return_address(0));
+    char *const *envp = exec_scrub(path, environ, &e);
+    if (envp != environ)
+        return NEXT(real_execve_fn, "execve")(path, webhelper_rewrite(path, argv, &w), envp);
+    return NEXT(real_execv_fn, "execv")(path, webhelper_rewrite(path, argv, &w));
+}
+
+STEAMFIX_EXPORT
+int execvp(const char *file, char *const argv[]) {
+    struct webhelper_argv w;
+    struct exec_env e;
+    exec_record(file, __builtin_return_address(0));
+    char *const *envp = exec_scrub(file, environ, &e);
+    if (envp != environ)
+        return NEXT(real_execvpe_fn, "execvpe")(file, webhelper_rewrite(file, argv, &w), envp);
+    return NEXT(real_execvp_fn, "execvp")(file, webhelper_rewrite(file, argv, &w));
+}
+
+STEAMFIX_EXPORT
+int execvpe(const char *file, char *const argv[], char *const envp[]) {
+    struct webhelper_argv w;
+    struct exec_env e;
+    exec_record(file, __builtin_return_address(0));
+    return NEXT(real_execvpe_fn, "execvpe")(file, webhelper_rewrite(file, argv, &w),
+                                            exec_scrub(file, envp, &e));
+}
+
+STEAMFIX_EXPORT
+int posix_spawn(pid_t *pid, const char *path, const posix_spawn_file_actions_t *actions,
+                const posix_spawnattr_t *attr, char *const argv[], char *const envp[]) {
+    struct webhelper_argv w;
+    struct exec_env e;
+    exec_record(path, __builtin_return_address(0));
+    return NEXT(real_posix_spawn_fn, "posix_spawn")(pid, path, actions, attr,
+                                                    webhelper_rewrite(path, argv, &w),
+                                                    exec_scrub(path, envp, &e));
+}
+
+STEAMFIX_EXPORT
+int posix_spawnp(pid_t *pid, const char *file, const posix_spawn_file_actions_t *actions,
+                 const posix_spawnattr_t *attr, char *const argv[], char *const envp[]) {
+    struct webhelper_argv w;
+    struct exec_env e;
+    exec_record(file, __builtin_return_address(0));
+    return NEXT(real_posix_spawnp_fn, "posix_spawnp")(pid, file, actions, attr,
+                                                      webhelper_rewrite(file, argv, &w),
+                                                      exec_scrub(file, envp, &e));
+}
+
+/* ── dlsym interception: route Chromium's libva stubs through us ─── */
+/*
+ * Chromium doesn't link against libva. Its generated stubs dlopen()
+ * libva.so.2 / libva-drm.so.2 and dlsym() every entry point from those
+ * handles, which only searches libva's own scope and never sees our
+ * LD_PRELOAD exports. So we interpose dlsym() itself and hand back our
+ * wrappers for the few names above, remembering libva's real entry point.
+ *
+ * RTLD_NEXT and RTLD_DEFAULT lookups are relative to the *caller*, which
+ * glibc finds via the return address. Those never touch the C code below:
+ * the assembly entry tail-jumps into libc with the caller's return
+ * address untouched.
+ */
+typedef void *(*real_dlsym_t)(void *, const char *);
+__attribute__((visibility("hidden"), used))
+real_dlsym_t steamfix_real_dlsym = NULL;
+
+static real_dlsym_t resolve_real_dlsym(void) {
+    real_dlsym_t fn = (real_dlsym_t)dlvsym(RTLD_NEXT, "dlsym", "GLIBC_2.34");
+    if (!fn)
+        fn = (real_dlsym_t)dlvsym(RTLD_NEXT, "dlsym", "GLIBC_2.2.5");
+    return fn;
+}
+
+__attribute__((visibility("hidden"), used))
+void *steamfix_dlsym_handle(void *handle, const char *symbol) {
+    real_dlsym_t real = __atomic_load_n(&steamfix_real_dlsym, __ATOMIC_ACQUIRE);
+    if (!real) {
+        real = resolve_real_dlsym();
+        __atomic_store_n(&steamfix_real_dlsym, real, __ATOMIC_RELEASE);
+    }
+    if (!real)
+        return NULL;
+
+    module_map_refresh();
+    void *sym = real(handle, symbol);
+    if (!sym || !symbol || symbol[0] != 'v' || symbol[1] != 'a')
+        return sym;
+    /* A handle to us (the libva stub) finds our own wrappers */
+    if (sym == (void *)vaInitialize || sym == (void *)vaGetDisplayDRM)
+        return sym;
+
+    if (strcmp(symbol, "vaInitialize") == 0) {
+        __atomic_store_n(&real_va_initialize, (va_initialize_t)sym, __ATOMIC_RELEASE);
+        return (void *)vaInitialize;
+    }
+    if (strcmp(symbol, "vaGetDisplayDRM") == 0) {
+        __atomic_store_n(&real_va_get_display_drm, (va_get_display_drm_t)sym,
+                         __ATOMIC_RELEASE);
+        return (void *)vaGetDisplayDRM;
+    }
+    return sym;
+}
+
+/* void *dlsym(void *handle, const char *symbol) */
+__asm__(
+    ".text\n"
+    ".globl dlsym\n"
+    ".type  dlsym, @function\n"
+    "dlsym:\n"
+    "    leaq  1(%rdi), %rax\n"              /* RTLD_NEXT (-1) → 0       */
+    "    cmpq  $1, %rax\n"                   /* RTLD_DEFAULT (0) → 1     */
+    "    ja    steamfix_dlsym_handle\n"      /* a real handle            */
+    "    movq  steamfix_real_dlsym(%rip), %rax\n"
+    "    testq %rax, %rax\n"
+    "    jz    steamfix_dlsym_handle\n"      /* before the constructor   */
+    "    jmp   *%rax\n"
+    ".size  dlsym, .-dlsym\n"
+);
+
+/* ── rtld-audit mode: LD_AUDIT=steam_cef_gpu_fix.so ─────────────── */
+/*
+ * Loaded as an audit module the library lives in its own link-map
+ * namespace, so none of the overrides above interpose anything. Instead
+ * the dynamic linker asks us about every binding from an object we flag
+ * BINDFROM (libcef.so) to one we flag BINDTO (libc, libva), and we swap
+ * in our overrides for the handful of names that need fixing — including
+ * the ones Chromium looks up with dlsym(), which glibc ≥ 2.35 audits too.
+ * Every other caller, and every other symbol, binds straight to libc at
+ * zero per-call cost. The constructor still installs the handlers.
+ */
+enum { AUDIT_FROM = 1, AUDIT_TO = 2 };
+
+static const char *const audit_from[] = { "libcef.so" };
+static const char *const audit_to[]   = { "libc.so.6", "libva.so.2", "libva-drm.so.2" };
+
+static int audit_match(const char *path, const char *const *names, size_t n) {
+    size_t len;
+    const char *base = elf_basename(path ? path : "", &len);
+    for (size_t i = 0; i < n; i++)
+        if (strlen(names[i]) == len && memcmp(base, names[i], len) == 0)
+            return 1;
+    return 0;
+}
+
+STEAMFIX_EXPORT
+unsigned int la_version(unsigned int version) {
+    audit_mode = 1;
+    return version < LAV_CURRENT ? version : LAV_CURRENT;
+}
+
+STEAMFIX_EXPORT
+unsigned int la_objopen(struct link_map *map, Lmid_t lmid, uintptr_t *cookie) {
+    (void)cookie;
+    if (lmid != LM_ID_BASE || disarmed)
+        return 0;
+    if (!audit_base) {
+        struct link_map *head = map;
+        while (head->l_prev)
+            head = head->l_prev;
+        __atomic_store_n(&audit_base, head, __ATOMIC_RELEASE);
+    }
+    unsigned int flags = 0;
+    if (audit_match(map->l_name, audit_from, sizeof(audit_from) / sizeof(*audit_from)))
+        flags |= LA_FLG_BINDFROM;
+    if (audit_match(map->l_name, audit_to, sizeof(audit_to) / sizeof(*audit_to)))
+        flags |= LA_FLG_BINDTO;
+    return flags;
+}
+
+/* New objects are in place: refresh the module map, as dlopen() would */
+STEAMFIX_EXPORT
+void la_activity(uintptr_t *cookie, unsigned int flag) {
+    (void)cookie;
+    if (flag == LA_ACT_CONSISTENT && !disarmed)
+        module_map_update();
+}
+
+/*
+ * Our pthread_atfork() handlers are registered with the audit namespace's
+ * libc, whose fork() the application never calls. libcef's fork() is
+ * bound here instead and does their work; its raw clone() goes through
+ * syscall() as usual. Forks from any other object skip it.
+ */
+typedef pid_t (*real_fork_t)(void);
+static real_fork_t audit_real_fork = NULL;
+
+static pid_t audit_fork(void) {
+    module_fork_prepare();
+    pid_t pid = __atomic_load_n(&audit_real_fork, __ATOMIC_ACQUIRE)();
+    module_fork_done();
+    if (pid == 0) {
+        telemetry_after_fork();
+        altstack_after_fork();
+    }
+    return pid;
+}
+
+STEAMFIX_EXPORT
+uintptr_t la_symbind64(Elf64_Sym *sym, unsigned int ndx, uintptr_t *refcook,
+                       uintptr_t *defcook, unsigned int *flags, const char *symname) {
+    (void)ndx; (void)refcook; (void)defcook;
+    *flags |= LA_SYMB_NOPLTENTER | LA_SYMB_NOPLTEXIT;
+    if (disarmed)
+        return sym->st_value;
+
+    if (strcmp(symname, "sigaction") == 0)
+        return (uintptr_t)sigaction;
+    if (strcmp(symname, "signal") == 0)
+        return (uintptr_t)signal;
+    if (strcmp(symname, "syscall") == 0)
+        return (uintptr_t)syscall;
+    if (strcmp(symname, "fork") == 0) {
+        __atomic_store_n(&audit_real_fork, (real_fork_t)sym->st_value, __ATOMIC_RELEASE);
+        return (uintptr_t)audit_fork;
+    }
+    if (strcmp(symname, "pthread_create") == 0) {
+        __atomic_store_n(&real_pthread_create_fn, (real_pthread_create_t)sym->st_value,
+                         __ATOMIC_RELEASE);
+        return (uintptr_t)pthread_create;
+    }
+    if (strcmp(symname, "vaInitialize") == 0) {
+        __atomic_store_n(&real_va_initialize, (va_initialize_t)sym->st_value,
+                         __ATOMIC_RELEASE);
+        return (uintptr_t)vaInitialize;
+    }
+    if (strcmp(symname, "vaGetDisplayDRM") == 0) {
+        __atomic_store_n(&real_va_get_display_drm, (va_get_display_drm_t)sym->st_value,
+                         __ATOMIC_RELEASE);
+        return (uintptr_t)vaGetDisplayDRM;
+    }
+    return sym->st_value;
+}
+
+#endif /* !STEAMFIX_MINIMAL */
+
+/* ── environment gate: is there anything to fix here? ───────────── */
+/*
+ * The README's alias makes LD_PRELOAD permanent, including on machines
+ * where steamwebhelper never crashes: an older kernel or NVIDIA driver,
+ * or a real VA-API driver such as nvidia-vaapi-driver. There the
+ * constructor takes one look and disarms, just as in a process it
+ * doesn't target: no handlers, and every override goes straight to libc.
+ *
+ * The crash needs all of
+ *   - kernel GATE_KERNEL or later (uname),
+ *   - NVIDIA's kernel module, GATE_NVIDIA or later (/sys/module/nvidia),
+ *   - no VA-API driver that serves NVIDIA's display (the cached
+ *     discovery; not in the minimal build, which has no VA-API code).
+ *     Other drivers, such as Mesa's, don't keep libva off the NULL slot.
+ * STEAMFIX_GATE=0 skips the check and always arms.
+ */
+#define GATE_KERNEL_MAJOR   6
+#define GATE_KERNEL_MINOR   13
+#define GATE_NVIDIA         580
+
+static int environment_needs_fix(void) {
+    const char *opt = getenv("STEAMFIX_GATE");
+    if (opt && opt[0] == '0')
+        return 1;
+
+    struct utsname u;
+    unsigned major = 0, minor = 0;
+    if (uname(&u) != 0 || sscanf(u.release, "%u.%u", &major, &minor) != 2)
+        return 1;       /* can't tell: err on the side of the fix */
+    if (major < GATE_KERNEL_MAJOR || (major == GATE_KERNEL_MAJOR && minor < GATE_KERNEL_MINOR))
+        return 0;
+
+    char version[32];
+    int fd = open("/sys/module/nvidia/version", O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return 0;
+    ssize_t n = read(fd, version, sizeof(version) - 1);
+    close(fd);
+    version[n > 0 ? n : 0] = 0;
+    if (strtoul(version, NULL, 10) < GATE_NVIDIA)
+        return 0;
+
+#ifndef STEAMFIX_MINIMAL
+    if (va_real_driver_for("nvidia-drm"))
+        return 0;
+#endif
+    return 1;
+}
+
+/* ── constructor ─────────────────────────────────────────────────── */
+__attribute__((constructor(101)))
+static void init(void) {
+    uint64_t start = __rdtsc();
+#ifndef STEAMFIX_MINIMAL
+    if (!steamfix_real_dlsym)
+        __atomic_store_n(&steamfix_real_dlsym, resolve_real_dlsym(), __ATOMIC_RELEASE);
+
+    /* Resolve and publish everything the overrides call into */
+    NEXT(real_sigaction_fn, "sigaction");
+    NEXT(real_syscall, "syscall");
+#endif
+
+    module_exe_init();
+    self_object();
+    policy_load();
+    if (!process_targeted() || !environment_needs_fix()) {
+        disarm();
+        return;
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_flags = SA_SIGINFO | SA_NODEFER | SA_ONSTACK;
+    sigemptyset(&sa.sa_mask);
+
+    /* Whatever was installed before us is where unrecovered faults go */
+    static const int sigs[] = { SIGSEGV, SIGTRAP, SIGILL };
+    for (unsigned i = 0; i < sizeof(sigs) / sizeof(sigs[0]); i++) {
+        struct sigaction prev;
+        sa.sa_sigaction = sigs[i] == SIGSEGV ? sigsegv_handler : crash_handler;
+        if (libc_sigaction(sigs[i], &sa, &prev) == 0 &&
+            prev.sa_sigaction != sigsegv_handler && prev.sa_sigaction != crash_handler)
+            disposition_set(sigs[i], &prev, NULL);
+    }
+
+    __atomic_store_n(&handlers_locked, 1, __ATOMIC_RELEASE);
+
+    altstack_init();
+    module_map_init();
+
+    /* Sites are profiled per libcef build, or per program without one */
+    size_t exe_len;
+    const char *exe = elf_basename(module_exe, &exe_len);
+    uint64_t build = module_build_id(steamfix_fnv1a(STEAMFIX_FNV_BASIS, "libcef.so", 9));
+    profile_init(build ? build : module_build_id(steamfix_fnv1a(STEAMFIX_FNV_BASIS, exe, exe_len)));
+#ifndef STEAMFIX_MINIMAL
+    va_null_driver_init();
+#endif
+
+    if (policy && policy->storm_threshold)
+        storm_threshold = policy->storm_threshold;
+    const char *threshold = getenv("STEAMFIX_STORM_THRESHOLD");
+    if (threshold && *threshold) {
+        unsigned long n = strtoul(threshold, NULL, 10);
+        storm_threshold = n && n < UINT32_MAX ? (uint32_t)n : UINT32_MAX;
+    }
+
+    const char *sites = getenv("STEAMFIX_SITES");
+    if (sites ? strcmp(sites, "any") == 0 : policy_flag(STEAMFIX_POLICY_SITES_ANY))
+        sites_anywhere = 1;
+    if (sites ? strcmp(sites, "unattributed") == 0
+              : policy_flag(STEAMFIX_POLICY_SITES_UNATTR))
+        sites_unattributed = 1;
 
-    sa.sa_sigaction = sigsegv_handler;
-    real_sigaction_fn(SIGSEGV, &sa, NULL);
+    const char *hotpatch = getenv("STEAMFIX_HOTPATCH");
+    hotpatch_enabled = hotpatch && hotpatch[0] == '1';
 
-    sa.sa_sigaction = crash_handler;
-    real_sigaction_fn(SIGTRAP, &sa, NULL);
-    real_sigaction_fn(SIGILL,  &sa, NULL);
+    const char *clone3_mode = getenv("STEAMFIX_CLONE3");
+    if ((clone3_mode ? strcmp(clone3_mode, "seccomp") == 0
+                     : policy_flag(STEAMFIX_POLICY_CLONE3_SECCOMP)) &&
+        install_clone3_filter() == 0)
+        clone3_in_kernel = 1;
 
-    handlers_locked = 1;
+    telemetry_init();
+    telemetry_record_named(STEAMFIX_EV_INIT, 0, 0, 0, __rdtsc() - start, exe, exe_len);
 }
@@ -0,0 +1,17 @@
+/*
+ * steam_cef_gpu_fix_i386.c — what 32-bit processes get at $LIB
+ *
+ * LD_PRELOAD applies to everything Steam starts, and the Steam client and
+ * many of its helpers are 32-bit. Given only the x86_64 library, each of
+ * those execs has ld.so open and map it just to reject the wrong ELF
+ * class and print an error. With LD_PRELOAD=.../$LIB/steam_cef_gpu_fix.so
+ * they load this instead.
+ *
+ * None of them load libcef: steamwebhelper, where the VA-API fault and
+ * crashpad live, is 64-bit only. So there is nothing to fix here, and
+ * this object is deliberately empty — no constructor, no symbols, no
+ * libc (it links with -nostdlib, so it builds without 32-bit libc
+ * installed). Loading it is one mmap, and the process runs unchanged.
+ *
+ * License: MIT
+ */
@@ -0,0 +1,80 @@
+/*
+ * steamfix_null_drv_video.c — VA-API backend driver that supports nothing
+ *
+ * Without a driver for the GPU, libva's vaInitialize() ends up calling
+ * through a vtable slot nobody filled in. steam_cef_gpu_fix.so points
+ * LIBVA_DRIVER_NAME/LIBVA_DRIVERS_PATH at this driver instead when it
+ * finds no real one: initialization succeeds at once, every entry point
+ * fails with VA_STATUS_ERROR_UNIMPLEMENTED and there are no profiles, so
+ * Chromium sees a GPU without video decode and moves on. No fault.
+ *
+ * libva's headers aren't needed (or always installed): the context and
+ * vtable prefixes below are the ones every libva 2.x has. The entry point
+ * is the 1.0 ABI name, which every libva 2.x still tries.
+ *
+ * License: MIT
+ */
+
+#include <stddef.h>
+
+typedef int VAStatus;
+#define VA_STATUS_SUCCESS               0x00000000
+#define VA_STATUS_ERROR_UNIMPLEMENTED   0x00000014
+
+/* struct VADriverContext from va_backend.h, up to str_vendor */
+struct va_driver_context {
+    void *driver_data;
+    void **vtable;              /* struct VADriverVTable, zeroed by libva */
+    void *vtable_glx, *vtable_egl, *vtable_tpi;
+    void *native_dpy;
+    int x11_screen;
+    int version_major, version_minor;
+    int max_profiles, max_entrypoints, max_attributes;
+    int max_image_formats, max_subpic_formats, max_display_attributes;
+    const char *str_vendor;
+};
+
+/*
+ * VADriverVTable slots libva refuses to run without (its CHECK_VTABLE
+ * list runs through vaSetDisplayAttributes, the 41st); the rest it
+ * checks for NULL before calling.
+ */
+#define VTABLE_REQUIRED             41
+#define VTABLE_TERMINATE            0
+#define VTABLE_QUERY_CONFIG_PROFILES 1
+
+static VAStatus null_unimplemented(void) {
+    return VA_STATUS_ERROR_UNIMPLEMENTED;
+}
+
+static VAStatus null_terminate(struct va_driver_context *ctx) {
+    (void)ctx;
+    return VA_STATUS_SUCCESS;
+}
+
+static VAStatus null_query_config_profiles(struct va_driver_context *ctx,
+                                           int *profiles, int *num_profiles) {
+    (void)ctx; (void)profiles;
+    *num_profiles = 0;
+    return VA_STATUS_SUCCESS;
+}
+
+__attribute__((visibility("default")))
+VAStatus __vaDriverInit_1_0(struct va_driver_context *ctx) {
+    ctx->version_major = 1;
+    ctx->version_minor = 0;
+    /* libva rejects a driver that leaves any maximum at 0 */
+    ctx->max_profiles = 1;
+    ctx->max_entrypoints = 1;
+    ctx->max_attributes = 1;
+    ctx->max_image_formats = 1;
+    ctx->max_subpic_formats = 1;
+    ctx->max_display_attributes = 1;
+    ctx->str_vendor = "steamfix null driver (no VA-API support)";
+
+    for (size_t i = 0; i < VTABLE_REQUIRED; i++)
+        ctx->vtable[i] = (void *)null_unimplemented;
+    ctx->vtable[VTABLE_TERMINATE] = (void *)null_terminate;
+    ctx->vtable[VTABLE_QUERY_CONFIG_PROFILES] = (void *)null_query_config_profiles;
+    return VA_STATUS_SUCCESS;
+}
@@ -0,0 +1,154 @@
+/*
+ * steamfix_policy.c — compile steamfix.conf into a steamfix.policy blob
+ *
+ *   steamfix-policy < steamfix.conf > steamfix.policy
+ *
+ * Config lines (format documented at the top of steamfix.conf):
+ *
+ *   storm_threshold <n>
+ *   recover any|listed|unattributed
+ *   clone3 syscall|seccomp
+ *   telemetry on|off
+ *   webhelper_args [<switch>...]
+ *   targets [<program>...]
+ *   site <module> <offset> <kinds>
+ *
+ * The output is laid out as steamfix_policy.h describes, checksummed,
+ * ready for the library to mmap().
+ *
+ * License: MIT
+ */
+
+#include "steamfix_policy.h"
+#include "steamfix_sitegen.h"
+
+static struct steamfix_policy policy;
+static char webhelper_args[1024];
+static char targets[1024];
+
+/* The rest of `line` after its first word, without surrounding blanks */
+static char *rest_of(char *line) {
+    char *p = line + strspn(line, " \t");
+    p += strcspn(p, " \t");
+    p += strspn(p, " \t");
+    size_t n = strlen(p);
+    while (n && (p[n - 1] == ' ' || p[n - 1] == '\t'))
+        p[--n] = 0;
+    return p;
+}
+
+static void parse(char *line) {
+    char key[64], value[128], extra[2];
+    int n = sscanf(line, "%63s %127s %1s", key, value, extra);
+    if (n <= 0)
+        return;
+
+    if (strcmp(key, "site") == 0) {
+        char module[128], offset[64], kinds[128];
+        if (sscanf(line, "%*s %127s %63s %127s %1s", module, offset, kinds, extra) != 3)
+            sitegen_die("expected site <module> <offset> <kinds>");
+        sitegen_add(module, offset, kinds);
+        return;
+    }
+    if (strcmp(key, "webhelper_args") == 0 || strcmp(key, "targets") == 0) {
+        int is_args = key[0] == 'w';
+        char *dst = is_args ? webhelper_args : targets;
+        const char *list = rest_of(line);
+        if (strlen(list) >= sizeof(webhelper_args))
+            sitegen_die(is_args ? "webhelper_args too long" : "targets too long");
+        strcpy(dst, list);
+        policy.flags |= is_args ? STEAMFIX_POLICY_WEBHELPER_ARGS : STEAMFIX_POLICY_TARGETS;
+        return;
+    }
+
+    if (n != 2)
+        sitegen_die("expected <key> <value>");
+    if (strcmp(key, "storm_threshold") == 0) {
+        char *end;
+        unsigned long v = strtoul(value, &end, 10);
+        if (*end || v == 0 || v >= UINT32_MAX)
+            sitegen_die("bad storm_threshold");
+        policy.storm_threshold = (uint32_t)v;
+    } else if (strcmp(key, "recover") == 0) {
+        policy.flags &= ~(STEAMFIX_POLICY_SITES_ANY | STEAMFIX_POLICY_SITES_UNATTR);
+        if (strcmp(value, "any") == 0)
+            policy.flags |= STEAMFIX_POLICY_SITES_ANY;
+        else if (strcmp(value, "unattributed") == 0)
+            policy.flags |= STEAMFIX_POLICY_SITES_UNATTR;
+        else if (strcmp(value, "listed") != 0)
+            sitegen_die("recover is any, listed or unattributed");
+    } else if (strcmp(key, "clone3") == 0) {
+        if (strcmp(value, "seccomp") == 0)
+            policy.flags |= STEAMFIX_POLICY_CLONE3_SECCOMP;
+        else if (strcmp(value, "syscall") == 0)
+            policy.flags &= ~STEAMFIX_POLICY_CLONE3_SECCOMP;
+        else
+            sitegen_die("clone3 is syscall or seccomp");
+    } else if (strcmp(key, "telemetry") == 0) {
+        if (strcmp(value, "off") == 0)
+            policy.flags |= STEAMFIX_POLICY_TELEMETRY_OFF;
+        else if (strcmp(value, "on") == 0)
+            policy.flags &= ~STEAMFIX_POLICY_TELEMETRY_OFF;
+        else
+            sitegen_die("telemetry is on or off");
+    } else {
+        sitegen_die("unknown key");
+    }
+}
+
+int main(void) {
+    char line[1200];
+    sitegen_tool = "steamfix-policy";
+    while (fgets(line, sizeof(line), stdin)) {
+        sitegen_line++;
+        line[strcspn(line, "#\n")] = 0;
+        parse(line);
+    }
+
+    static unsigned char blob[STEAMFIX_POLICY_MAX_SIZE];
+    size_t size = sizeof(policy);
+
+    if (sitegen_count) {
+        uint64_t seed;
+        unsigned bits = sitegen_solve(&seed);
+        if (size + (sizeof(struct steamfix_site) << bits) >
+            sizeof(blob) - sizeof(webhelper_args) - sizeof(targets)) {
+            fputs("steamfix-policy: too many sites\n", stderr);
+            return 1;
+        }
+        struct steamfix_site *table = (struct steamfix_site *)(blob + size);
+        for (unsigned i = 0; i < sitegen_count; i++) {
+            const struct steamfix_site *s = &sitegen_entries[i].site;
+            table[steamfix_site_slot(s->module, s->offset, seed, bits)] = *s;
+        }
+        policy.sites_off = (uint32_t)size;
+        policy.sites_bits = bits;
+        policy.sites_seed = seed;
+        size += sizeof(*table) << bits;
+    }
+    if (policy.flags & STEAMFIX_POLICY_WEBHELPER_ARGS) {
+        policy.webhelper_args_off = (uint32_t)size;
+        memcpy(blob + size, webhelper_args, strlen(webhelper_args) + 1);
+        size += strlen(webhelper_args) + 1;
+    }
+    if (policy.flags & STEAMFIX_POLICY_TARGETS) {
+        policy.targets_off = (uint32_t)size;
+        memcpy(blob + size, targets, strlen(targets) + 1);
+        size += strlen(targets) + 1;
+    }
+    size = (size + 7) & ~(size_t)7;
+
+    policy.magic = STEAMFIX_POLICY_MAGIC;
+    policy.version = STEAMFIX_POLICY_VERSION;
+    policy.size = (uint32_t)size;
+    memcpy(blob, &policy, sizeof(policy));
+    policy.checksum = steamfix_fnv1a(STEAMFIX_FNV_BASIS, blob + STEAMFIX_POLICY_CHECKED_FROM,
+                                     size - STEAMFIX_POLICY_CHECKED_FROM);
+    memcpy(blob, &policy, sizeof(policy));
+
+    if (fwrite(blob, 1, size, stdout) != size || fflush(stdout) != 0) {
+        perror("steamfix-policy: write");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,60 @@
+/*
+ * steamfix_policy.h — precompiled policy blob
+ *
+ * steamfix-policy compiles a text config (steamfix.conf) into a blob the
+ * library maps read-only in its constructor: one mmap() of a file every
+ * process shares through the page cache, a checksum, and no parsing or
+ * allocation in each of the dozen processes Steam starts.
+ *
+ * The blob is a header followed by the sections it points to, located by
+ * byte offsets from the start of the blob so it works wherever it is
+ * mapped. Everything is little-endian and naturally aligned.
+ *
+ * Environment variables still override what the policy says.
+ *
+ * License: MIT
+ */
+
+#ifndef STEAMFIX_POLICY_H
+#define STEAMFIX_POLICY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "steamfix_sites.h"
+
+#define STEAMFIX_POLICY_MAGIC       0x31304c4f50584653ull   /* "SFXPOL01" */
+#define STEAMFIX_POLICY_VERSION     1
+#define STEAMFIX_POLICY_MAX_SIZE    (1u << 20)
+#define STEAMFIX_POLICY_FILE        "steamfix.policy"       /* next to the .so */
+#define STEAMFIX_POLICY_ENV         "STEAMFIX_POLICY"
+
+/* steamfix_policy.flags */
+#define STEAMFIX_POLICY_SITES_ANY       0x01u   /* recover everywhere        */
+#define STEAMFIX_POLICY_CLONE3_SECCOMP  0x02u   /* STEAMFIX_CLONE3=seccomp   */
+#define STEAMFIX_POLICY_TELEMETRY_OFF   0x04u   /* STEAMFIX_TELEMETRY=0      */
+#define STEAMFIX_POLICY_WEBHELPER_ARGS  0x08u   /* webhelper_args is set     */
+#define STEAMFIX_POLICY_TARGETS         0x10u   /* targets is set            */
+#define STEAMFIX_POLICY_SITES_UNATTR    0x20u   /* and where no module is    */
+
+struct steamfix_policy {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t size;              /* of the whole blob, bytes              */
+    uint64_t checksum;          /* FNV-1a of everything after this field */
+    uint32_t flags;             /* STEAMFIX_POLICY_*                     */
+    uint32_t storm_threshold;   /* 0: built-in default                   */
+
+    /* Extra crash sites, a perfect-hash table like crash_sites.h's */
+    uint32_t sites_off;         /* struct steamfix_site[1 << sites_bits] */
+    uint32_t sites_bits;        /* 0: no table                           */
+    uint64_t sites_seed;
+
+    uint32_t webhelper_args_off;    /* NUL-terminated switch list        */
+    uint32_t targets_off;           /* NUL-terminated program names      */
+};
+
+#define STEAMFIX_POLICY_CHECKED_FROM \
+    (offsetof(struct steamfix_policy, checksum) + sizeof(uint64_t))
+
+#endif /* STEAMFIX_POLICY_H */
@@ -0,0 +1,152 @@
+/*
+ * steamfix_sitegen.h — crash-site lists for the build tools
+ *
+ * Shared by gen-crash-sites and steamfix-policy: parses site lines
+ * (format documented at the top of crash_sites.txt), merges duplicate
+ * sites, and searches for a seed under which every site lands in its own
+ * slot of the smallest power-of-two table at least twice the number of
+ * sites. The library indexes the result with steamfix_site_slot() — no
+ * allocation, no probing. Not for the library itself.
+ *
+ * License: MIT
+ */
+
+#ifndef STEAMFIX_SITEGEN_H
+#define STEAMFIX_SITEGEN_H
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "steamfix_sites.h"
+
+#define SITEGEN_MAX_SITES   1024
+#define SITEGEN_MAX_BITS    16
+#define SITEGEN_MAX_SEEDS   (1u << 20)
+
+static struct sitegen_entry {
+    struct steamfix_site site;
+    char text[330];                     /* for comments in the output */
+} sitegen_entries[SITEGEN_MAX_SITES];
+static unsigned sitegen_count;
+
+static const char *sitegen_tool;        /* for error messages */
+static int sitegen_line;
+
+static void sitegen_die(const char *what) {
+    fprintf(stderr, "%s: line %d: %s\n", sitegen_tool, sitegen_line, what);
+    exit(1);
+}
+
+static int sitegen_hex_digit(int c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    c = tolower(c);
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+static uint64_t sitegen_module_hash(const char *m) {
+    if (strncmp(m, "build-id:", 9) != 0)
+        return steamfix_fnv1a(STEAMFIX_FNV_BASIS, m, strlen(m));
+
+    unsigned char id[64];
+    size_t n = 0;
+    const char *p = m + 9;
+    for (; p[0] && p[1]; p += 2) {
+        int hi = sitegen_hex_digit(p[0]), lo = sitegen_hex_digit(p[1]);
+        if (hi < 0 || lo < 0 || n == sizeof(id))
+            sitegen_die("bad build-id");
+        id[n++] = (unsigned char)(hi << 4 | lo);
+    }
+    if (*p || n == 0)
+        sitegen_die("bad build-id");
+    return steamfix_fnv1a_hex(STEAMFIX_FNV_BASIS, id, n);
+}
+
+static uint32_t sitegen_parse_kinds(char *s) {
+    uint32_t kinds = 0;
+    for (char *k = strtok(s, ","); k; k = strtok(NULL, ",")) {
+        if (strcmp(k, "call") == 0)       kinds |= STEAMFIX_SITE_CALL;
+        else if (strcmp(k, "deref") == 0) kinds |= STEAMFIX_SITE_DEREF;
+        else if (strcmp(k, "trap") == 0)  kinds |= STEAMFIX_SITE_TRAP | STEAMFIX_SITE_STUB;
+        else if (strcmp(k, "stub") == 0)  kinds |= STEAMFIX_SITE_STUB;
+        else if (strcmp(k, "any") == 0)
+            kinds |= STEAMFIX_SITE_CALL | STEAMFIX_SITE_DEREF |
+                     STEAMFIX_SITE_TRAP | STEAMFIX_SITE_STUB;
+        else
+            sitegen_die("unknown kind");
+    }
+    return kinds;
+}
+
+static void sitegen_add(const char *module, const char *offset, char *kinds) {
+    struct steamfix_site s;
+    s.module = sitegen_module_hash(module);
+    if (s.module == 0)
+        sitegen_die("module hashes to 0");
+    if (strcmp(offset, "*") == 0) {
+        s.offset = STEAMFIX_SITE_ANYWHERE;
+    } else if (isalpha((unsigned char)offset[0]) || offset[0] == '_') {
+        for (const char *c = offset; *c; c++)
+            if (!isalnum((unsigned char)*c) && *c != '_' && *c != '.')
+                sitegen_die("bad symbol");
+        s.offset = steamfix_site_symbol(offset, strlen(offset));
+    } else {
+        char *end;
+        s.offset = strtoull(offset, &end, 0);
+        if (*end || (s.offset & STEAMFIX_SITE_SYMBOL))
+            sitegen_die("bad offset");
+    }
+    char text[330];
+    snprintf(text, sizeof(text), "%s %s %s", module, offset, kinds);
+    s.kinds = sitegen_parse_kinds(kinds);
+
+    for (unsigned i = 0; i < sitegen_count; i++)
+        if (sitegen_entries[i].site.module == s.module &&
+            sitegen_entries[i].site.offset == s.offset) {
+            sitegen_entries[i].site.kinds |= s.kinds;
+            return;
+        }
+    if (sitegen_count == SITEGEN_MAX_SITES)
+        sitegen_die("too many sites");
+    sitegen_entries[sitegen_count].site = s;
+    strcpy(sitegen_entries[sitegen_count].text, text);
+    sitegen_count++;
+}
+
+/* Seed under which all sites get distinct slots of 2^bits, or 0 */
+static uint64_t sitegen_find_seed(unsigned bits) {
+    static unsigned char used[1u << SITEGEN_MAX_BITS];
+    uint64_t seed = 0;
+    for (unsigned attempt = 0; attempt < SITEGEN_MAX_SEEDS; attempt++) {
+        seed += 0x9E3779B97F4A7C15ull;          /* never 0 in 2^20 steps */
+        memset(used, 0, (size_t)1 << bits);
+        unsigned i;
+        for (i = 0; i < sitegen_count; i++) {
+            uint32_t slot = steamfix_site_slot(sitegen_entries[i].site.module,
+                                               sitegen_entries[i].site.offset, seed, bits);
+            if (used[slot])
+                break;
+            used[slot] = 1;
+        }
+        if (i == sitegen_count)
+            return seed;
+    }
+    return 0;
+}
+
+/* Table size (log2) and seed for the sites added so far */
+static unsigned sitegen_solve(uint64_t *seed) {
+    unsigned bits = 4;
+    while ((1u << bits) < 2 * sitegen_count)
+        bits++;
+    while (!(*seed = sitegen_find_seed(bits)))
+        if (++bits > SITEGEN_MAX_BITS) {
+            fprintf(stderr, "%s: no perfect hash found\n", sitegen_tool);
+            exit(1);
+        }
+    return bits;
+}
+
+#endif /* STEAMFIX_SITEGEN_H */
@@ -0,0 +1,78 @@
+/*
+ * steamfix_sites.h — crash-site allowlist lookup
+ *
+ * The sites the handlers may recover from are listed in crash_sites.txt;
+ * gen-crash-sites turns that into crash_sites.h at build time: a table of
+ * 2^STEAMFIX_SITES_BITS slots and a seed for which every (module, offset)
+ * pair hashes to its own slot, so a lookup is one hash and one compare.
+ *
+ * A module is identified either by its GNU build-id, hashed as lowercase
+ * hex, or by its SONAME (file name if it has none); both hash with FNV-1a.
+ * Offsets are ELF virtual addresses (what objdump and addr2line print),
+ * or stand for a function of the module's dynamic symbol table (its name's
+ * FNV-1a with STEAMFIX_SITE_SYMBOL set), matching all of [st_value, +st_size).
+ * STEAMFIX_SITE_ANYWHERE matches the whole module. Empty slots have module 0.
+ *
+ * License: MIT
+ */
+
+#ifndef STEAMFIX_SITES_H
+#define STEAMFIX_SITES_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Which recoveries a site is allowed */
+#define STEAMFIX_SITE_CALL      1u      /* call through NULL (rip < 0x10000)      */
+#define STEAMFIX_SITE_DEREF     2u      /* NULL dereference (si_addr < 0x10000)   */
+#define STEAMFIX_SITE_TRAP      4u      /* int3/ud2 anywhere                      */
+#define STEAMFIX_SITE_STUB      8u      /* int3/ud2 of an outlined NOTREACHED stub:
+                                           push rbp; mov rbp,rsp; int3|ud2      */
+
+#define STEAMFIX_SITE_ANYWHERE  UINT64_MAX
+#define STEAMFIX_SITE_SYMBOL    0x8000000000000000ull
+
+#define STEAMFIX_FNV_BASIS      0xcbf29ce484222325ull
+
+struct steamfix_site {
+    uint64_t module;
+    uint64_t offset;
+    uint32_t kinds;                     /* STEAMFIX_SITE_* mask */
+};
+
+static inline uint64_t steamfix_fnv1a(uint64_t h, const void *data, size_t len) {
+    const unsigned char *p = (const unsigned char *)data;
+    for (size_t i = 0; i < len; i++)
+        h = (h ^ p[i]) * 0x100000001b3ull;
+    return h;
+}
+
+/* FNV-1a of the lowercase hex spelling of `data`, without spelling it out */
+static inline uint64_t steamfix_fnv1a_hex(uint64_t h, const void *data, size_t len) {
+    static const char hex[] = "0123456789abcdef";
+    const unsigned char *p = (const unsigned char *)data;
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ (unsigned char)hex[p[i] >> 4]) * 0x100000001b3ull;
+        h = (h ^ (unsigned char)hex[p[i] & 15]) * 0x100000001b3ull;
+    }
+    return h;
+}
+
+/* The offset that stands for the function `name` */
+static inline uint64_t steamfix_site_symbol(const char *name, size_t len) {
+    uint64_t h = steamfix_fnv1a(STEAMFIX_FNV_BASIS, name, len) | STEAMFIX_SITE_SYMBOL;
+    return h == STEAMFIX_SITE_ANYWHERE ? h - 1 : h;
+}
+
+static inline uint32_t steamfix_site_slot(uint64_t module, uint64_t offset,
+                                          uint64_t seed, unsigned bits) {
+    uint64_t x = module ^ (offset * 0x9E3779B97F4A7C15ull) ^ seed;
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ull;
+    x ^= x >> 33;
+    return (uint32_t)(x >> (64 - bits));
+}
+
+#endif /* STEAMFIX_SITES_H */
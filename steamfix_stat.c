@@ -0,0 +1,507 @@
+/*
+ * steamfix_stat.c — live counters for steam_cef_gpu_fix.so
+ *
+ * Attaches read-only to a session's telemetry segment (see
+ * steamfix_telemetry.h) and shows, per process, how often the recovery
+ * paths fire, refreshing like `perf top`:
+ *
+ *   steamfix-stat                 newest live session, 1 s refresh
+ *   steamfix-stat -s 12345 -d 2   session 12345, 2 s refresh
+ *   steamfix-stat -1              print once and exit (for scripts)
+ *   steamfix-stat -t trace.json   export the ring as a Chrome trace-event
+ *                                 timeline (Perfetto, chrome://tracing)
+ *
+ * Counts are what the tool has observed in the ring since it started
+ * (plus whatever the ring still held then). If more events arrive
+ * between two refreshes than the ring holds, the excess is reported as
+ * lost.
+ *
+ * License: MIT
+ */
+
+#define _GNU_SOURCE
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <x86intrin.h>
+
+#include "steamfix_telemetry.h"
+
+#define MAX_PROCS  256
+#define MAX_SITES  1024
+#define TOP_SITES  15
+
+#define MAX_KINDS  16
+
+struct proc_stat {
+    uint32_t pid;
+    char     comm[17];
+    uint64_t total[MAX_KINDS];  /* by STEAMFIX_EV_*, cumulative          */
+    uint64_t last[MAX_KINDS];   /* ... at the previous refresh           */
+    uint64_t reraise;
+};
+
+struct site_stat {
+    uint64_t rip, addr, count;
+    uint32_t pid;
+    uint16_t kind, path;
+};
+
+static struct proc_stat procs[MAX_PROCS];
+static unsigned         nprocs;
+static struct site_stat sites[MAX_SITES];
+static unsigned         nsites;
+static uint64_t         events_seen, events_lost;
+
+static const char *kind_name(unsigned kind) {
+    switch (kind) {
+    case STEAMFIX_EV_SIGSEGV:   return "SEGV";
+    case STEAMFIX_EV_CRASH:     return "TRAP";
+    case STEAMFIX_EV_SIGACTION: return "SIGACT";
+    case STEAMFIX_EV_SIGNAL:    return "SIGNAL";
+    case STEAMFIX_EV_CLONE3:    return "CLONE3";
+    case STEAMFIX_EV_INIT:      return "INIT";
+    case STEAMFIX_EV_VA_INIT:   return "VAINIT";
+    case STEAMFIX_EV_EXEC:      return "EXEC";
+    case STEAMFIX_EV_FORK:      return "FORK";
+    }
+    return "?";
+}
+
+static const char *path_name(unsigned path) {
+    switch (path) {
+    case STEAMFIX_PATH_RETURN:   return "return";
+    case STEAMFIX_PATH_FRAMES_1: return "1-frame";
+    case STEAMFIX_PATH_FRAMES_2: return "2-frame";
+    case STEAMFIX_PATH_FRAMES_3: return "3-frame";
+    case STEAMFIX_PATH_RERAISE:  return "re-raise";
+    case STEAMFIX_PATH_BLOCKED:  return "blocked";
+    case STEAMFIX_PATH_ENOSYS:   return "ENOSYS";
+    case STEAMFIX_PATH_UNLISTED: return "unlisted";
+    case STEAMFIX_PATH_CHAINED:  return "chained";
+    case STEAMFIX_PATH_PASSED:   return "passed";
+    case STEAMFIX_PATH_FAILED:   return "failed";
+    case STEAMFIX_PATH_PATCHED:  return "patched";
+    }
+    return "?";
+}
+
+static struct proc_stat *proc_for(uint32_t pid) {
+    for (unsigned i = 0; i < nprocs; i++)
+        if (procs[i].pid == pid)
+            return &procs[i];
+    if (nprocs == MAX_PROCS)
+        return NULL;
+
+    struct proc_stat *p = &procs[nprocs++];
+    memset(p, 0, sizeof(*p));
+    p->pid = pid;
+
+    char path[32];
+    snprintf(path, sizeof(path), "/proc/%u/comm", pid);
+    FILE *f = fopen(path, "r");
+    if (!f || !fgets(p->comm, sizeof(p->comm), f))
+        strcpy(p->comm, "(exited)");
+    if (f)
+        fclose(f);
+    p->comm[strcspn(p->comm, "\n")] = 0;
+    return p;
+}
+
+static void count_site(const struct steamfix_event *e) {
+    for (unsigned i = 0; i < nsites; i++) {
+        struct site_stat *s = &sites[i];
+        if (s->rip == e->rip && s->addr == e->addr && s->pid == e->pid &&
+            s->kind == e->kind && s->path == e->path) {
+            s->count++;
+            return;
+        }
+    }
+    if (nsites == MAX_SITES)
+        return;
+    sites[nsites++] = (struct site_stat){
+        .rip = e->rip, .addr = e->addr, .count = 1,
+        .pid = e->pid, .kind = e->kind, .path = e->path,
+    };
+}
+
+/* ── Chrome trace-event export ─────────────────────────────────────── */
+/*
+ * -t writes what the ring holds as a JSON trace (the "JSON Array Format"
+ * Perfetto and chrome://tracing load): INIT and VA_INIT as slices with
+ * their duration, everything else as instants, keyed by pid/tid, with a
+ * process_name for each process. Timestamps are microseconds since the
+ * session started, converted from rdtsc with a rate measured here.
+ */
+static FILE    *trace;
+static double   trace_tsc_per_us;
+static uint64_t trace_base_tsc;
+static int      trace_count;
+
+static uint64_t now_tsc_ns(uint64_t *ns) {
+    struct timespec ts;
+    uint64_t tsc = __rdtsc();
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    *ns = (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+    return tsc;
+}
+
+static void trace_begin(FILE *f, const struct steamfix_telemetry *t) {
+    uint64_t ns0, ns1, tsc0 = now_tsc_ns(&ns0);
+    struct timespec wait = { 0, 20000000 };
+    nanosleep(&wait, NULL);
+    uint64_t tsc1 = now_tsc_ns(&ns1);
+    trace_tsc_per_us = (double)(tsc1 - tsc0) / ((double)(ns1 - ns0) / 1000.0);
+    trace_base_tsc = t->created_tsc;
+    trace = f;
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", trace);
+}
+
+static double trace_us(uint64_t tsc) {
+    return tsc > trace_base_tsc ? (double)(tsc - trace_base_tsc) / trace_tsc_per_us : 0.0;
+}
+
+/* `len` bytes of `s` (up to its NUL) as a JSON string */
+static void trace_string(const char *s, size_t len) {
+    fputc('"', trace);
+    for (size_t i = 0; i < len && s[i]; i++) {
+        unsigned char c = (unsigned char)s[i];
+        if (c == '"' || c == '\\')
+            fprintf(trace, "\\%c", c);
+        else if (c < 0x20)
+            fprintf(trace, "\\u%04x", c);
+        else
+            fputc(c, trace);
+    }
+    fputc('"', trace);
+}
+
+static void trace_event(const struct steamfix_event *e) {
+    const char *cat = "recovery", *ph = "i", *scope = "t";
+    double ts = trace_us(e->tsc), dur = 0;
+    char name[48];
+
+    switch (e->kind) {
+    case STEAMFIX_EV_SIGSEGV:
+    case STEAMFIX_EV_CRASH:
+        snprintf(name, sizeof(name), "%s %s", kind_name(e->kind), path_name(e->path));
+        break;
+    case STEAMFIX_EV_SIGACTION:
+    case STEAMFIX_EV_SIGNAL:
+        snprintf(name, sizeof(name), "%s blocked",
+                 e->kind == STEAMFIX_EV_SIGACTION ? "sigaction" : "signal");
+        cat = "lockout";
+        break;
+    case STEAMFIX_EV_CLONE3:
+        snprintf(name, sizeof(name), "clone3 ENOSYS");
+        cat = "clone3";
+        break;
+    case STEAMFIX_EV_INIT:
+    case STEAMFIX_EV_VA_INIT:
+        snprintf(name, sizeof(name), "%s", e->kind == STEAMFIX_EV_INIT ? "init" : "vaInitialize");
+        cat = e->kind == STEAMFIX_EV_INIT ? "process" : "libva";
+        ph = "X";
+        dur = (double)e->addr / trace_tsc_per_us;
+        ts = ts > dur ? ts - dur : 0;
+        break;
+    case STEAMFIX_EV_EXEC:
+        snprintf(name, sizeof(name), "exec %.16s", e->comm);
+        cat = "process";
+        scope = "p";
+        break;
+    case STEAMFIX_EV_FORK:
+        snprintf(name, sizeof(name), "fork");
+        cat = "process";
+        scope = "p";
+        break;
+    default:
+        return;
+    }
+
+    fprintf(trace, "%s{\"name\":", trace_count++ ? ",\n" : "");
+    trace_string(name, sizeof(name));
+    fprintf(trace, ",\"cat\":\"%s\",\"ph\":\"%s\",\"ts\":%.3f,\"pid\":%u,\"tid\":%u",
+            cat, ph, ts, e->pid, e->tid);
+    if (*ph == 'X')
+        fprintf(trace, ",\"dur\":%.3f", dur);
+    else
+        fprintf(trace, ",\"s\":\"%s\"", scope);
+
+    fputs(",\"args\":{", trace);
+    switch (e->kind) {
+    case STEAMFIX_EV_INIT:
+        fputs("\"program\":", trace);
+        trace_string(e->comm, sizeof(e->comm));
+        break;
+    case STEAMFIX_EV_VA_INIT:
+        fprintf(trace, "\"path\":\"%s\",\"status\":%d,\"caller\":\"0x%llx\"",
+                path_name(e->path), (int)e->sig, (unsigned long long)e->rip);
+        break;
+    case STEAMFIX_EV_EXEC:
+        fputs("\"program\":", trace);
+        trace_string(e->comm, sizeof(e->comm));
+        fprintf(trace, ",\"caller\":\"0x%llx\"", (unsigned long long)e->rip);
+        break;
+    case STEAMFIX_EV_FORK:
+        fprintf(trace, "\"parent\":%llu", (unsigned long long)e->addr);
+        break;
+    default:
+        fprintf(trace, "\"sig\":%u,\"rip\":\"0x%llx\",\"addr\":\"0x%llx\"",
+                e->sig, (unsigned long long)e->rip, (unsigned long long)e->addr);
+    }
+    fputs("}}", trace);
+}
+
+static void trace_end(void) {
+    for (unsigned i = 0; i < nprocs; i++) {
+        fprintf(trace, "%s{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%u,"
+                "\"args\":{\"name\":", trace_count++ ? ",\n" : "", procs[i].pid);
+        trace_string(procs[i].comm, sizeof(procs[i].comm));
+        fputs("}}", trace);
+    }
+    fputs("\n]}\n", trace);
+}
+
+static void account(const struct steamfix_event *e) {
+    struct proc_stat *p = proc_for(e->pid);
+    if (p && e->kind < MAX_KINDS)
+        p->total[e->kind]++;
+    /* /proc is gone once the process is, its INIT event is not */
+    if (p && e->kind == STEAMFIX_EV_INIT && e->comm[0]) {
+        memcpy(p->comm, e->comm, sizeof(e->comm));
+        p->comm[sizeof(e->comm)] = 0;
+    }
+    if (p && (e->path == STEAMFIX_PATH_RERAISE || e->path == STEAMFIX_PATH_UNLISTED ||
+              e->path == STEAMFIX_PATH_CHAINED))
+        p->reraise++;
+    if (e->kind == STEAMFIX_EV_SIGSEGV || e->kind == STEAMFIX_EV_CRASH)
+        count_site(e);
+    if (trace)
+        trace_event(e);
+    events_seen++;
+}
+
+/* Copy slot `idx` out of the ring; 0 if it was rewritten under us */
+static int read_event(const struct steamfix_telemetry *t, uint64_t idx,
+                      struct steamfix_event *out) {
+    const struct steamfix_event *e = &t->events[idx & (STEAMFIX_TELEMETRY_EVENTS - 1)];
+    uint64_t seq = __atomic_load_n(&e->seq, __ATOMIC_ACQUIRE);
+    if (seq != idx + 1)
+        return 0;
+    memcpy(out, (const void *)e, sizeof(*out));
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&e->seq, __ATOMIC_RELAXED) == seq;
+}
+
+/* Account for everything published since the previous call */
+static void drain(const struct steamfix_telemetry *t, uint64_t *tail) {
+    uint64_t head = __atomic_load_n(&t->head, __ATOMIC_ACQUIRE);
+    if (head - *tail > STEAMFIX_TELEMETRY_EVENTS) {
+        events_lost += head - *tail - STEAMFIX_TELEMETRY_EVENTS;
+        *tail = head - STEAMFIX_TELEMETRY_EVENTS;
+    }
+    for (; *tail < head; (*tail)++) {
+        struct steamfix_event e;
+        int ok = 0;
+        /* A writer may still be filling the slot; give it a moment */
+        for (int tries = 0; tries < 100 && !(ok = read_event(t, *tail, &e)); tries++)
+            sched_yield();
+        if (ok)
+            account(&e);
+        else
+            events_lost++;
+    }
+}
+
+static int cmp_site(const void *a, const void *b) {
+    const struct site_stat *x = a, *y = b;
+    return x->count < y->count ? 1 : x->count > y->count ? -1 : 0;
+}
+
+static double rate(const struct proc_stat *p, int kind, double secs) {
+    return secs > 0 ? (double)(p->total[kind] - p->last[kind]) / secs : 0.0;
+}
+
+static void render(unsigned session, double secs, int clear) {
+    if (clear)
+        fputs("\033[H\033[2J", stdout);
+    printf("steamfix-stat  session %u  %.1fs  %llu events  %llu lost\n\n",
+           session, secs, (unsigned long long)events_seen,
+           (unsigned long long)events_lost);
+
+    printf("%-8s %-16s %8s %8s %8s %8s %7s %7s %8s\n", "PID", "COMM",
+           "SEGV/s", "TRAP/s", "SEGV", "TRAP", "SIGACT", "CLONE3", "RERAISE");
+    for (unsigned i = 0; i < nprocs; i++) {
+        struct proc_stat *p = &procs[i];
+        printf("%-8u %-16s %8.1f %8.1f %8llu %8llu %7llu %7llu %8llu\n",
+               p->pid, p->comm,
+               rate(p, STEAMFIX_EV_SIGSEGV, secs), rate(p, STEAMFIX_EV_CRASH, secs),
+               (unsigned long long)p->total[STEAMFIX_EV_SIGSEGV],
+               (unsigned long long)p->total[STEAMFIX_EV_CRASH],
+               (unsigned long long)(p->total[STEAMFIX_EV_SIGACTION] +
+                                    p->total[STEAMFIX_EV_SIGNAL]),
+               (unsigned long long)p->total[STEAMFIX_EV_CLONE3],
+               (unsigned long long)p->reraise);
+        memcpy(p->last, p->total, sizeof(p->last));
+    }
+
+    qsort(sites, nsites, sizeof(sites[0]), cmp_site);
+    printf("\n%10s  %-6s %-9s %-8s %-18s %s\n",
+           "COUNT", "KIND", "PATH", "PID", "RIP", "ADDR");
+    for (unsigned i = 0; i < nsites && i < TOP_SITES; i++) {
+        struct site_stat *s = &sites[i];
+        printf("%10llu  %-6s %-9s %-8u 0x%016llx 0x%llx\n",
+               (unsigned long long)s->count, kind_name(s->kind),
+               path_name(s->path), s->pid,
+               (unsigned long long)s->rip, (unsigned long long)s->addr);
+    }
+    fflush(stdout);
+}
+
+/* Newest session of ours whose owner is still alive */
+static unsigned find_session(void) {
+    char prefix[32];
+    snprintf(prefix, sizeof(prefix), "steamfix-%u-", getuid());
+    size_t plen = strlen(prefix);
+
+    DIR *d = opendir("/dev/shm");
+    if (!d)
+        return 0;
+    unsigned best = 0;
+    time_t best_time = 0;
+    struct dirent *e;
+    while ((e = readdir(d)) != NULL) {
+        if (strncmp(e->d_name, prefix, plen) != 0)
+            continue;
+        char *end;
+        unsigned long session = strtoul(e->d_name + plen, &end, 10);
+        if (*end || !session || (kill((pid_t)session, 0) != 0 && errno == ESRCH))
+            continue;
+        char path[300];
+        struct stat st;
+        snprintf(path, sizeof(path), "/dev/shm/%s", e->d_name);
+        if (stat(path, &st) == 0 && st.st_ctime >= best_time) {
+            best = (unsigned)session;
+            best_time = st.st_ctime;
+        }
+    }
+    closedir(d);
+    return best;
+}
+
+static const struct steamfix_telemetry *attach(unsigned session) {
+    char path[64];
+    if (steamfix_telemetry_path(path, sizeof(path), getuid(), session))
+        return NULL;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        fprintf(stderr, "steamfix-stat: %s: %s\n", path, strerror(errno));
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(struct steamfix_telemetry)) {
+        fprintf(stderr, "steamfix-stat: %s: truncated segment\n", path);
+        close(fd);
+        return NULL;
+    }
+    if (!S_ISREG(st.st_mode) || st.st_uid != getuid() || (st.st_mode & 07777) != 0600) {
+        fprintf(stderr, "steamfix-stat: %s: not a private segment of this user\n", path);
+        close(fd);
+        return NULL;
+    }
+    const struct steamfix_telemetry *t =
+        mmap(NULL, sizeof(*t), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (t == MAP_FAILED)
+        return NULL;
+    if (__atomic_load_n(&t->magic, __ATOMIC_ACQUIRE) != STEAMFIX_TELEMETRY_MAGIC ||
+        t->version != STEAMFIX_TELEMETRY_VERSION) {
+        fprintf(stderr, "steamfix-stat: %s: unknown segment format\n", path);
+        return NULL;
+    }
+    return t;
+}
+
+static void usage(void) {
+    fputs("usage: steamfix-stat [-s session] [-d seconds] [-1] [-t trace.json]\n", stderr);
+    exit(2);
+}
+
+int main(int argc, char **argv) {
+    unsigned session = 0;
+    double delay = 1.0;
+    int once = 0, opt;
+    const char *trace_path = NULL;
+
+    while ((opt = getopt(argc, argv, "s:d:1t:h")) != -1) {
+        switch (opt) {
+        case 's': session = (unsigned)strtoul(optarg, NULL, 10); break;
+        case 'd': delay = atof(optarg); break;
+        case '1': once = 1; break;
+        case 't': trace_path = optarg; break;
+        default:  usage();
+        }
+    }
+    if (delay <= 0)
+        usage();
+    if (!session && !(session = find_session())) {
+        fputs("steamfix-stat: no live session found in /dev/shm\n", stderr);
+        return 1;
+    }
+
+    const struct steamfix_telemetry *t = attach(session);
+    if (!t)
+        return 1;
+
+    /* Start at the oldest event the ring still holds */
+    uint64_t head = __atomic_load_n(&t->head, __ATOMIC_ACQUIRE);
+    uint64_t tail = head > STEAMFIX_TELEMETRY_EVENTS ? head - STEAMFIX_TELEMETRY_EVENTS : 0;
+
+    if (trace_path) {
+        FILE *f = strcmp(trace_path, "-") == 0 ? stdout : fopen(trace_path, "w");
+        if (!f) {
+            fprintf(stderr, "steamfix-stat: %s: %s\n", trace_path, strerror(errno));
+            return 1;
+        }
+        trace_begin(f, t);
+        drain(t, &tail);
+        trace_end();
+        if (fclose(f) != 0) {
+            fprintf(stderr, "steamfix-stat: %s: %s\n", trace_path, strerror(errno));
+            return 1;
+        }
+        if (f != stdout)
+            fprintf(stderr, "steamfix-stat: %d events (%llu lost) written to %s\n",
+                    trace_count - (int)nprocs, (unsigned long long)events_lost, trace_path);
+        return 0;
+    }
+
+    struct timespec prev, now;
+    clock_gettime(CLOCK_MONOTONIC, &prev);
+    drain(t, &tail);
+    if (once) {
+        render(session, 0, 0);
+        return 0;
+    }
+
+    for (;;) {
+        struct timespec ts = { (time_t)delay, (long)((delay - (time_t)delay) * 1e9) };
+        nanosleep(&ts, NULL);
+        drain(t, &tail);
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        double secs = (double)(now.tv_sec - prev.tv_sec) +
+                      (double)(now.tv_nsec - prev.tv_nsec) / 1e9;
+        prev = now;
+        render(session, secs, isatty(STDOUT_FILENO));
+    }
+}
@@ -0,0 +1,94 @@
+/*
+ * steamfix_telemetry.h — shared-memory fault telemetry ring
+ *
+ * Layout of the segment that steam_cef_gpu_fix.so records into and that
+ * companion tools read. One segment per Steam session, named after the
+ * pid of the first process that loaded the library (exported to children
+ * as STEAMFIX_SESSION), at /dev/shm/steamfix-<uid>-<session>.
+ *
+ * Every field has a fixed width so 32- and 64-bit processes of the same
+ * session agree on the layout.
+ *
+ * Writers claim a slot with one fetch-add on `head` and publish it
+ * seqlock-style: `seq` is zeroed, the payload stored, then `seq` set to
+ * slot index + 1 with release semantics. Readers copy a slot between two
+ * loads of `seq` and keep it only if both equal the index they expect.
+ *
+ * License: MIT
+ */
+
+#ifndef STEAMFIX_TELEMETRY_H
+#define STEAMFIX_TELEMETRY_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define STEAMFIX_TELEMETRY_MAGIC    0x31304c4554584653ull   /* "SFXTEL01" */
+#define STEAMFIX_TELEMETRY_VERSION  1
+#define STEAMFIX_TELEMETRY_EVENTS   4096                    /* power of two */
+#define STEAMFIX_SESSION_ENV        "STEAMFIX_SESSION"
+
+/* What fired */
+enum steamfix_event_kind {
+    STEAMFIX_EV_SIGSEGV = 1,    /* sigsegv_handler()                     */
+    STEAMFIX_EV_CRASH,          /* crash_handler(), SIGTRAP/SIGILL       */
+    STEAMFIX_EV_SIGACTION,      /* crashpad sigaction() locked out       */
+    STEAMFIX_EV_SIGNAL,         /* signal() locked out                   */
+    STEAMFIX_EV_CLONE3,         /* syscall(SYS_clone3) denied            */
+    STEAMFIX_EV_INIT,           /* constructor finished                  */
+    STEAMFIX_EV_VA_INIT,        /* vaInitialize() returned               */
+    STEAMFIX_EV_EXEC,           /* exec*() or posix_spawn*() called      */
+    STEAMFIX_EV_FORK,           /* first event of a forked child         */
+};
+
+/* What the library did about it */
+enum steamfix_event_path {
+    STEAMFIX_PATH_RETURN = 1,   /* returned 0 to the address at rsp      */
+    STEAMFIX_PATH_FRAMES_1,     /* returned 0 out of one frame           */
+    STEAMFIX_PATH_FRAMES_2,     /* ... two frames                        */
+    STEAMFIX_PATH_FRAMES_3,     /* ... three frames (storm escalation)   */
+    STEAMFIX_PATH_RERAISE,      /* SIG_DFL + re-raise                    */
+    STEAMFIX_PATH_BLOCKED,      /* handler installation refused          */
+    STEAMFIX_PATH_ENOSYS,       /* failed with ENOSYS                    */
+    STEAMFIX_PATH_UNLISTED,     /* not an allowlisted site, passed on    */
+    STEAMFIX_PATH_CHAINED,      /* passed to the app's own handler       */
+    STEAMFIX_PATH_PASSED,       /* went on to the real function          */
+    STEAMFIX_PATH_FAILED,       /* failed by the pre-check, libva unentered */
+    STEAMFIX_PATH_PATCHED,      /* stub rewritten to recover without a trap */
+};
+
+struct steamfix_event {
+    uint64_t seq;               /* slot index + 1 once complete, 0 while written */
+    uint64_t tsc;               /* rdtsc at the decision                 */
+    uint64_t rip;               /* faulting rip, call site for NULL calls and hooks */
+    uint64_t addr;              /* si_addr, or the handler that was refused;
+                                   INIT, VA_INIT: rdtsc ticks spent in it;
+                                   FORK: the parent's pid                */
+    uint32_t pid;
+    uint32_t tid;
+    uint16_t kind;              /* STEAMFIX_EV_*                         */
+    uint16_t path;              /* STEAMFIX_PATH_*, 0 if none            */
+    uint32_t sig;               /* signal; VA_INIT: the VAStatus         */
+    char     comm[16];          /* INIT: program name, EXEC: the target's;
+                                   NUL-padded, unterminated at 16        */
+} __attribute__((aligned(64)));
+
+struct steamfix_telemetry {
+    uint64_t magic;             /* set last, once the header is valid    */
+    uint32_t version;
+    uint32_t capacity;          /* == STEAMFIX_TELEMETRY_EVENTS          */
+    uint32_t init;              /* 0 → 1 claimed by the creating process */
+    uint32_t session;
+    uint64_t created_tsc;
+    uint64_t created_ns;        /* CLOCK_MONOTONIC at created_tsc        */
+    uint64_t head __attribute__((aligned(64)));     /* next slot to claim */
+    struct steamfix_event events[STEAMFIX_TELEMETRY_EVENTS];
+};
+
+static inline int steamfix_telemetry_path(char *buf, size_t len,
+                                          unsigned uid, unsigned session) {
+    int n = snprintf(buf, len, "/dev/shm/steamfix-%u-%u", uid, session);
+    return n > 0 && (size_t)n < len ? 0 : -1;
+}
+
+#endif /* STEAMFIX_TELEMETRY_H */